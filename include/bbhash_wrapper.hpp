@@ -3,10 +3,55 @@
 #include <fcntl.h>
 #include <sstream>
 
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "utils.hpp"
+
 #include "../external/bbhash/BooPHF.h"
 
 namespace mphf {
 
+/**
+ * Hasher of BBhash that combines the seeds passed by BBhash with the seed of the structure, which
+ * it stores; the seed 0 leaves `Hasher` unchanged. BBhash offers no way to pass a hasher: it
+ * default-constructs its hashers when the structure is created, on the creating thread. So the
+ * wrapper creates its structure within a `Seeding` scope, which hands the seed of the wrapper to
+ * the hashers created meanwhile by the same thread, and then the structure keeps their copies.
+ */
+template <typename Hasher>
+struct BBhashSeededHasher {
+    template <typename T>
+    inline uint64_t operator()(T const& key, uint64_t seed = 0) const {
+        return m_hasher(key, seed ^ m_seed);
+    }
+
+    /**
+     * Gives `seed` to the hashers default-constructed by this thread during its lifetime
+     */
+    struct Seeding {
+        Seeding(uint64_t seed) : m_previous(creation_seed()) {
+            creation_seed() = seed;
+        }
+        ~Seeding() {
+            creation_seed() = m_previous;
+        }
+        Seeding(Seeding const&) = delete;
+        Seeding& operator=(Seeding const&) = delete;
+
+    private:
+        uint64_t m_previous;
+    };
+
+private:
+    static uint64_t& creation_seed() {
+        thread_local uint64_t seed = 0;
+        return seed;
+    }
+
+    uint64_t m_seed = creation_seed();
+    Hasher m_hasher;
+};
+
 template <typename T, typename Hasher>
 struct BBhashWrapper {
     struct Builder {
@@ -24,35 +69,52 @@ struct BBhashWrapper {
             m_name = ss.str();
         }
 
-        BBhashWrapper build(const std::vector<T>& keys, uint64_t seed = 0,
-                            bool verbose = false) const {
+        BBhashWrapper build(KeySpan<T> keys, uint64_t seed = 0,
+                            bool verbose = false, BuildStats* stats = nullptr) const {
             BBhashWrapper bbhash_wrapper;
-            build(bbhash_wrapper, keys, seed, verbose);
+            build(bbhash_wrapper, keys, seed, verbose, stats);
             return bbhash_wrapper;
         }
 
-        void build(BBhashWrapper& bbhash_wrapper, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(BBhashWrapper& bbhash_wrapper, KeySpan<T> keys, uint64_t seed = 0,
+                   bool verbose = false, BuildStats* stats = nullptr) const {
+            Chrono chrono;
+            chrono.start();
             auto data_iterator = boomphf::iter_range(keys.begin(), keys.end());
-            bbhash_wrapper.m_bbhash = boomphf::mphf<T, Hasher>(
+            bbhash_wrapper.m_seed = seed;
+            typename SeededHasher::Seeding seeding(bbhash_wrapper.m_seed);
+            bbhash_wrapper.m_bbhash = boomphf::mphf<T, SeededHasher>(
                 keys.size(), data_iterator, m_num_threads, m_gamma, true, verbose, 0.0);
+            chrono.stop();
+            if (stats) stats->add_phase("construction", chrono.elapsed_time());
         }
 
         std::string name() const {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return m_num_threads;
+        }
+
+        /**
+         * @return true if the structure depends on the seed passed to `build`
+         */
+        bool seeded() const {
+            return true;
+        }
+
     private:
         double m_gamma;
         uint32_t m_num_threads;
         std::string m_name;
     };
 
-    inline uint64_t operator()(const T& key) {  // this should be const but `lookup` is not const
+    inline uint64_t operator()(const T& key) const {
         return m_bbhash.lookup(key);
     }
 
-    inline size_t num_bits() {  // this should be const but `totalBitSize` is not const
+    inline size_t num_bits() const {
         // I must capture the stdout because the `totalBitSize` prints some debug information
         int old_fd, new_fd;
         fflush(stdout);
@@ -70,8 +132,26 @@ struct BBhashWrapper {
         return num_bits;
     }
 
+    void save(std::ostream& os) const {
+        os.write(reinterpret_cast<const char*>(&m_seed), sizeof(m_seed));
+        m_bbhash.save(os);
+    }
+
+    void load(std::istream& is) {
+        is.read(reinterpret_cast<char*>(&m_seed), sizeof(m_seed));
+        // the hashers of the loaded structure take the seed when they are created
+        typename SeededHasher::Seeding seeding(m_seed);
+        m_bbhash = boomphf::mphf<T, SeededHasher>();
+        m_bbhash.load(is);
+    }
+
 private:
-    boomphf::mphf<T, Hasher> m_bbhash;
+    using SeededHasher = BBhashSeededHasher<Hasher>;
+
+    uint64_t m_seed = 0;
+    // `lookup` and `totalBitSize` are not declared const, although `lookup` only reads the
+    // structure and is safe to call concurrently
+    mutable boomphf::mphf<T, SeededHasher> m_bbhash;
 };
 
 }  // namespace mphf
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "result_record.hpp"
+#include "summary_statistics.hpp"
+
+/**
+ * Parses a record written by `ResultWriter` in the JSON format: a flat object whose values are
+ * strings, numbers, booleans, nulls or arrays of numbers and nulls
+ */
+class JsonRecordParser {
+public:
+    static ResultRecord parse(std::string const& line) {
+        JsonRecordParser parser(line);
+        ResultRecord record;
+        parser.expect('{');
+        if (parser.consume('}')) return parser.end(record);
+        do {
+            std::string name = parser.string();
+            parser.expect(':');
+            parser.value(name, record);
+        } while (parser.consume(','));
+        parser.expect('}');
+        return parser.end(record);
+    }
+
+private:
+    JsonRecordParser(std::string const& line) : m_line(line), m_pos(0) {}
+
+    void value(std::string const& name, ResultRecord& record) {
+        skip_spaces();
+        if (m_pos == m_line.size()) error("a value");
+        char c = m_line[m_pos];
+        if (c == '"') {
+            record.add(name, string());
+        } else if (c == '[') {
+            ++m_pos;
+            std::vector<double> values;
+            if (!consume(']')) {
+                do { values.push_back(number()); } while (consume(','));
+                expect(']');
+            }
+            record.add(name, values);
+        } else if (keyword("true")) {
+            record.add(name, true);
+        } else if (keyword("false")) {
+            record.add(name, false);
+        } else {
+            // integers are kept as such, so that their text (e.g., the number of keys) is the
+            // same as in the records of the benchmark
+            size_t begin = m_pos;
+            double value = number();
+            std::string token = m_line.substr(begin, m_pos - begin);
+            if (token.find_first_of(".eE") == std::string::npos && token != "null" &&
+                std::abs(value) < 9e18) {
+                record.add(name, static_cast<int64_t>(std::stoll(token)));
+            } else {
+                record.add(name, value);
+            }
+        }
+    }
+
+    double number() {
+        skip_spaces();
+        if (keyword("null")) return std::nan("");
+        const char* begin = m_line.c_str() + m_pos;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin) error("a number");
+        m_pos += end - begin;
+        return value;
+    }
+
+    std::string string() {
+        expect('"');
+        std::string result;
+        while (true) {
+            if (m_pos == m_line.size()) error("the end of the string");
+            char c = m_line[m_pos++];
+            if (c == '"') return result;
+            if (c != '\\') {
+                result.push_back(c);
+                continue;
+            }
+            if (m_pos == m_line.size()) error("an escape sequence");
+            c = m_line[m_pos++];
+            switch (c) {
+                case 'n':
+                    result.push_back('\n');
+                    break;
+                case 't':
+                    result.push_back('\t');
+                    break;
+                case 'r':
+                    result.push_back('\r');
+                    break;
+                case 'b':
+                    result.push_back('\b');
+                    break;
+                case 'f':
+                    result.push_back('\f');
+                    break;
+                case 'u':
+                    // the writer escapes only control characters in this way
+                    if (m_pos + 4 > m_line.size()) error("four hexadecimal digits");
+                    result.push_back(
+                        static_cast<char>(std::stoi(m_line.substr(m_pos, 4), nullptr, 16)));
+                    m_pos += 4;
+                    break;
+                default:
+                    result.push_back(c);  // `"`, `\`, `/`
+            }
+        }
+    }
+
+    bool keyword(const char* word) {
+        std::string w(word);
+        if (m_line.compare(m_pos, w.size(), w) != 0) return false;
+        m_pos += w.size();
+        return true;
+    }
+
+    void skip_spaces() {
+        while (m_pos != m_line.size() && std::isspace(static_cast<unsigned char>(m_line[m_pos]))) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(char c) {
+        skip_spaces();
+        if (m_pos == m_line.size() || m_line[m_pos] != c) return false;
+        ++m_pos;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) error(std::string("`") + c + "`");
+    }
+
+    ResultRecord const& end(ResultRecord const& record) {
+        skip_spaces();
+        if (m_pos != m_line.size()) error("the end of the record");
+        return record;
+    }
+
+    [[noreturn]] void error(std::string const& expected) const {
+        throw std::runtime_error("Expected " + expected + " at column " +
+                                 std::to_string(m_pos + 1));
+    }
+
+    std::string const& m_line;
+    size_t m_pos;
+};
+
+/**
+ * @return The records of a file written with `--format json`, one per non-empty line
+ */
+inline std::vector<ResultRecord> read_json_records(std::istream& is) {
+    std::vector<ResultRecord> records;
+    std::string line;
+    for (uint64_t line_number = 1; std::getline(is, line); ++line_number) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        try {
+            records.push_back(JsonRecordParser::parse(line));
+        } catch (std::exception const& e) {
+            throw std::runtime_error("Malformed record at line " + std::to_string(line_number) +
+                                     ": " + e.what());
+        }
+    }
+    return records;
+}
+
+/**
+ * Maximum relative worsening of each compared metric, parsed from a specification such as
+ * `lookup_ns_per_key=5,bits_per_key=0.5`, in percent. The metrics whose name ends with `_per_sec`
+ * are throughputs, which worsen when they decrease; the other ones worsen when they increase.
+ */
+class RegressionThresholds {
+public:
+    RegressionThresholds()
+        : m_thresholds{{"bits_per_key", 0.01},
+                       {"construction_seconds", 0.10},
+                       {"lookup_ns_per_key", 0.05}} {}
+
+    explicit RegressionThresholds(std::string const& spec) {
+        std::stringstream ss(spec);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item.empty()) continue;
+            size_t equal = item.find('=');
+            size_t end = 0;
+            double percent = -1;
+            if (equal != std::string::npos && equal != 0) {
+                try {
+                    percent = std::stod(item.substr(equal + 1), &end);
+                } catch (std::exception const&) { end = 0; }
+            }
+            if (end == 0 || equal + 1 + end != item.size() || !(percent >= 0)) {
+                throw std::invalid_argument("Malformed threshold `" + item +
+                                            "`, expected `metric=percent`");
+            }
+            m_thresholds[item.substr(0, equal)] = percent / 100;
+        }
+        if (m_thresholds.empty()) throw std::invalid_argument("No regression threshold given");
+    }
+
+    inline std::map<std::string, double> const& thresholds() const {
+        return m_thresholds;
+    }
+
+    static bool higher_is_better(std::string const& metric) {
+        const std::string suffix = "_per_sec";
+        return metric.size() >= suffix.size() &&
+               metric.compare(metric.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+private:
+    std::map<std::string, double> m_thresholds;
+};
+
+/**
+ * Outcome of the comparison of a metric of a variant with the baseline
+ */
+struct MetricComparison {
+    std::string variant;
+    std::string metric;
+    SummaryStatistics baseline, current;
+    double change;     // relative worsening of the median (negative if improved, NaN if the
+                       // baseline median is zero)
+    double threshold;  // maximum relative worsening
+    bool conclusive;   // whether the samples can tell a regression (see `BaselineComparison`)
+    bool regressed;
+};
+
+/**
+ * Compares the records of a run with the records of a baseline run. The records of the same
+ * variant (see `variant`) are pooled: each one contributes the value of each metric, or all its
+ * values if it is an array (e.g., `construction_seconds`), so that repeated runs form samples of
+ * the metric. A metric regresses if its median worsens by more than its threshold and, to tell
+ * regressions from noise, if the samples of the two runs do not overlap (every current value is
+ * worse than every baseline value). As a few samples overlap by chance too rarely to tell noise,
+ * a baseline with fewer than `min_samples` samples of a metric is rejected, and a metric with
+ * fewer than `min_samples` samples in the current run, or with a zero baseline median (which has
+ * no relative change), is inconclusive and never regresses.
+ */
+class BaselineComparison {
+public:
+    static constexpr uint64_t min_samples = 3;
+
+    /**
+     * @throws std::invalid_argument if the baseline has fewer than `min_samples` samples of a
+     * compared metric of a variant, i.e., if it was not recorded with enough repetitions
+     */
+    BaselineComparison(std::vector<ResultRecord> const& baseline,
+                       RegressionThresholds const& thresholds)
+        : m_thresholds(thresholds) {
+        for (auto const& record : baseline) {
+            // skip the records that are not the outcome of a test, such as sweep summaries
+            if (!record.contains("verification")) continue;
+            m_baseline[variant(record)].push_back(record);
+        }
+        for (auto const& [name, records] : m_baseline) {
+            for (auto const& entry : m_thresholds.thresholds()) {
+                uint64_t count = samples(records, entry.first).size();
+                if (count == 0 || count >= min_samples) continue;
+                throw std::invalid_argument(
+                    "The baseline has " + std::to_string(count) + " samples of `" + entry.first +
+                    "` for " + name + ", fewer than " + std::to_string(min_samples) +
+                    ": record it with --repeat " + std::to_string(min_samples) + " or more");
+            }
+        }
+    }
+
+    /**
+     * @return The comparison of each metric of each variant of `current` that is also in the
+     * baseline, in the order of `current`
+     */
+    std::vector<MetricComparison> compare(std::vector<ResultRecord> const& current) const {
+        std::vector<std::string> order;
+        std::map<std::string, std::vector<ResultRecord>> grouped;
+        for (auto const& record : current) {
+            if (!record.contains("verification")) continue;
+            std::string name = variant(record);
+            if (!grouped.count(name)) order.push_back(name);
+            grouped[name].push_back(record);
+        }
+        std::vector<MetricComparison> comparisons;
+        for (auto const& name : order) {
+            auto it = m_baseline.find(name);
+            if (it == m_baseline.end()) continue;
+            for (auto const& [metric, threshold] : m_thresholds.thresholds()) {
+                std::vector<double> baseline_samples = samples(it->second, metric);
+                std::vector<double> current_samples = samples(grouped[name], metric);
+                if (baseline_samples.empty() || current_samples.empty()) continue;
+                MetricComparison comparison{name, metric, baseline_samples, current_samples,
+                                            0, threshold, false, false};
+                double base = comparison.baseline.median, cur = comparison.current.median;
+                bool higher_is_better = RegressionThresholds::higher_is_better(metric);
+                comparison.change = base == 0 ? std::nan("")
+                                    : higher_is_better ? (base - cur) / base
+                                                       : (cur - base) / base;
+                bool separated = higher_is_better
+                                     ? comparison.current.max < comparison.baseline.min
+                                     : comparison.current.min > comparison.baseline.max;
+                comparison.conclusive = base != 0 && comparison.baseline.count >= min_samples &&
+                                        comparison.current.count >= min_samples;
+                comparison.regressed =
+                    comparison.conclusive && comparison.change > threshold && separated;
+                comparisons.push_back(comparison);
+            }
+        }
+        return comparisons;
+    }
+
+    /**
+     * @return The variants of the baseline that are not in `current`
+     */
+    std::vector<std::string> missing(std::vector<ResultRecord> const& current) const {
+        std::map<std::string, bool> found;
+        for (auto const& record : current) found[variant(record)] = true;
+        std::vector<std::string> result;
+        for (auto const& entry : m_baseline) {
+            if (!found.count(entry.first)) result.push_back(entry.first);
+        }
+        return result;
+    }
+
+    /**
+     * @return The name identifying the variant tested by `record`: its algorithm and parameters,
+     * and the keys, threads and queries it was tested with
+     */
+    static std::string variant(ResultRecord const& record) {
+        std::string name = record.text("algorithm") + " [n=" + record.text("n") + ", " +
+                           record.text("key_type") + ", gen=" + record.text("generator") +
+                           ", threads=" + record.text("threads");
+        if (record.contains("query_distribution")) {
+            name += ", queries=" + record.text("query_distribution");
+        }
+        return name + "]";
+    }
+
+private:
+    static std::vector<double> samples(std::vector<ResultRecord> const& records,
+                                       std::string const& metric) {
+        std::vector<double> result;
+        for (auto const& record : records) {
+            for (auto const& field : record.fields()) {
+                if (field.name != metric) continue;
+                if (field.type == ResultRecord::FieldType::ARRAY) {
+                    for (auto const& value : field.values) {
+                        if (!value.empty()) result.push_back(std::stod(value));
+                    }
+                } else if (!std::isnan(field.number)) {
+                    result.push_back(field.number);
+                }
+            }
+        }
+        return result;
+    }
+
+    RegressionThresholds m_thresholds;
+    std::map<std::string, std::vector<ResultRecord>> m_baseline;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * State of the caches during the lookups under cache pressure
+ */
+enum class CacheMode {
+    WARM,       // no pressure: the structure stays in the caches between lookups
+    COLD,       // the caches are flushed by streaming over a scratch buffer between batches
+    ANTAGONIST  // a concurrent thread keeps streaming over a scratch buffer during the lookups
+};
+
+inline CacheMode parse_cache_mode(std::string const& name) {
+    if (name == "warm") return CacheMode::WARM;
+    if (name == "cold") return CacheMode::COLD;
+    if (name == "antagonist") return CacheMode::ANTAGONIST;
+    throw std::invalid_argument("Unknown cache mode `" + name +
+                                "`, expected one of `warm`, `cold`, `antagonist`");
+}
+
+inline const char* cache_mode_name(CacheMode mode) {
+    switch (mode) {
+        case CacheMode::WARM:
+            return "warm";
+        case CacheMode::COLD:
+            return "cold";
+        case CacheMode::ANTAGONIST:
+            return "antagonist";
+    }
+    return "";
+}
+
+/**
+ * @return The size in bytes of the largest data cache of the first processor, as reported by
+ * sysfs, or 0 if unknown
+ */
+inline uint64_t last_level_cache_bytes() {
+    uint64_t result = 0;
+    for (int index = 0; index != 8; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index);
+        std::ifstream type_file(dir + "/type"), size_file(dir + "/size");
+        std::string type, size;
+        if (!(type_file >> type) || !(size_file >> size)) continue;
+        if (type == "Instruction" || size.empty()) continue;
+        uint64_t bytes = std::stoull(size);
+        if (size.back() == 'K') bytes <<= 10;
+        if (size.back() == 'M') bytes <<= 20;
+        result = std::max(result, bytes);
+    }
+    return result;
+}
+
+/**
+ * Evicts the data of the benchmark from the caches (and the TLB) by updating every cache line of a
+ * scratch buffer that is larger than the last-level cache
+ */
+class CacheEvictor {
+public:
+    CacheEvictor(uint64_t num_bytes) : m_buffer(std::max<uint64_t>(num_bytes / 8, 1), 1) {}
+
+    void evict() {
+        for (uint64_t i = 0; i < m_buffer.size(); i += words_per_line) { m_buffer[i] += m_sum; }
+        m_sum += m_buffer[m_buffer.size() / 2];
+    }
+
+    inline uint64_t num_bytes() const {
+        return m_buffer.size() * 8;
+    }
+
+private:
+    static constexpr uint64_t words_per_line = 64 / 8;
+    std::vector<uint64_t> m_buffer;
+    uint64_t m_sum = 0;
+};
+
+/**
+ * Thread that competes for the memory bandwidth and the last-level cache, by streaming over a
+ * scratch buffer from its creation until its destruction
+ */
+class BandwidthAntagonist {
+public:
+    BandwidthAntagonist(uint64_t num_bytes) : m_evictor(num_bytes), m_stop(false), m_passes(0) {
+        m_thread = std::thread([this] {
+            while (!m_stop.load(std::memory_order_relaxed)) {
+                m_evictor.evict();
+                m_passes.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    BandwidthAntagonist(BandwidthAntagonist const&) = delete;
+    BandwidthAntagonist& operator=(BandwidthAntagonist const&) = delete;
+
+    ~BandwidthAntagonist() {
+        m_stop = true;
+        m_thread.join();
+    }
+
+    /**
+     * @return The number of complete passes over the scratch buffer so far
+     */
+    inline uint64_t passes() const {
+        return m_passes.load(std::memory_order_relaxed);
+    }
+
+private:
+    CacheEvictor m_evictor;
+    std::atomic<bool> m_stop;
+    std::atomic<uint64_t> m_passes;
+    std::thread m_thread;
+};
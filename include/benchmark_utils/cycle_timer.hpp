@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Low-overhead timer based on the cycle counter of the processor, used to time single operations.
+ * Ticks are converted to nanoseconds by calibrating the counter against
+ * `std::chrono::steady_clock`, and the cost of reading the counter is measured so that it can be
+ * subtracted from each timing. On architectures without a known cycle counter the timer falls back
+ * to `steady_clock`.
+ */
+class CycleTimer {
+public:
+    /**
+     * Reads the counter before the timed operation, preventing earlier instructions from being
+     * executed after the read and later instructions from being executed before it
+     */
+    static inline uint64_t start() {
+#if defined(__x86_64__)
+        uint32_t lo, hi;
+        asm volatile("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi)::"memory");
+        return (static_cast<uint64_t>(hi) << 32) | lo;
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks)::"memory");
+        return ticks;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /**
+     * Reads the counter after the timed operation, waiting for its instructions to complete
+     */
+    static inline uint64_t stop() {
+#if defined(__x86_64__)
+        uint32_t lo, hi;
+        asm volatile("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi)::"rcx", "memory");
+        return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+        return start();
+#endif
+    }
+
+    static const char* name() {
+#if defined(__x86_64__)
+        return "rdtsc";
+#elif defined(__aarch64__)
+        return "cntvct";
+#else
+        return "steady_clock";
+#endif
+    }
+
+    /**
+     * Estimates the duration of a tick and the overhead of a start/stop pair.
+     * @param calibration_ms The wall-clock time spent measuring the tick rate
+     */
+    void calibrate(uint32_t calibration_ms = 50) {
+        using ClockType = std::chrono::steady_clock;
+        auto wall_start = ClockType::now();
+        uint64_t ticks_start = start();
+        while (ClockType::now() - wall_start < std::chrono::milliseconds(calibration_ms)) {}
+        uint64_t ticks_stop = stop();
+        auto wall_stop = ClockType::now();
+        double elapsed_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(wall_stop - wall_start).count();
+        m_ns_per_tick = elapsed_ns / std::max<uint64_t>(ticks_stop - ticks_start, 1);
+
+        // the overhead is the median cost of timing an empty region
+        const uint32_t num_overhead_samples = 10001;
+        std::vector<uint64_t> overheads(num_overhead_samples);
+        for (auto& overhead : overheads) {
+            uint64_t t0 = start();
+            uint64_t t1 = stop();
+            overhead = t1 - t0;
+        }
+        std::nth_element(overheads.begin(), overheads.begin() + num_overhead_samples / 2,
+                         overheads.end());
+        m_overhead_ticks = overheads[num_overhead_samples / 2];
+    }
+
+    /**
+     * @return The duration in nanoseconds of the interval [t0, t1], net of the timer overhead
+     */
+    inline double elapsed_ns(uint64_t t0, uint64_t t1) const {
+        uint64_t ticks = t1 - t0;
+        ticks = ticks > m_overhead_ticks ? ticks - m_overhead_ticks : 0;
+        return ticks * m_ns_per_tick;
+    }
+
+    inline double ns_per_tick() const {
+        return m_ns_per_tick;
+    }
+
+    inline double overhead_ns() const {
+        return m_overhead_ticks * m_ns_per_tick;
+    }
+
+private:
+    double m_ns_per_tick = 1.0;
+    uint64_t m_overhead_ticks = 0;
+};
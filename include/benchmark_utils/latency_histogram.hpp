@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "result_record.hpp"
+
+/**
+ * Distribution of the latencies (in nanoseconds) of individually timed operations.
+ * Percentiles are computed on the exact samples, while the histogram groups them in buckets whose
+ * bounds grow geometrically (`buckets_per_octave` buckets for each power of two).
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram(uint32_t buckets_per_octave = 4) : m_buckets_per_octave(buckets_per_octave) {}
+
+    inline void reserve(size_t num_samples) {
+        m_samples.reserve(num_samples);
+    }
+
+    inline void add(double latency_ns) {
+        m_samples.push_back(latency_ns);
+        m_sorted = false;
+    }
+
+    inline size_t size() const {
+        return m_samples.size();
+    }
+
+    double mean() const {
+        if (m_samples.empty()) { return std::nan(""); }
+        double sum = 0;
+        for (double sample : m_samples) { sum += sample; }
+        return sum / m_samples.size();
+    }
+
+    /**
+     * @param p The percentile to compute, between 0 and 100
+     * @return The smallest sample greater or equal to p% of the samples (nearest-rank method)
+     */
+    double percentile(double p) {
+        if (m_samples.empty()) { return std::nan(""); }
+        sort();
+        size_t rank = std::ceil(p / 100.0 * m_samples.size());
+        return m_samples[std::min(std::max<size_t>(rank, 1), m_samples.size()) - 1];
+    }
+
+    /**
+     * @return The upper bound (exclusive) of each non-empty bucket, and its number of samples
+     */
+    std::pair<std::vector<double>, std::vector<uint64_t>> buckets() {
+        std::vector<double> bounds;
+        std::vector<uint64_t> counts;
+        sort();
+        for (double sample : m_samples) {
+            double bound = upper_bound(sample);
+            if (bounds.empty() || bounds.back() != bound) {
+                bounds.push_back(bound);
+                counts.push_back(0);
+            }
+            ++counts.back();
+        }
+        return {bounds, counts};
+    }
+
+    /**
+     * Adds the summary statistics and the histogram to `record`, prefixing each field by `prefix`
+     */
+    void report(ResultRecord& record, std::string const& prefix) {
+        record.add(prefix + "_samples", m_samples.size());
+        record.add(prefix + "_mean_ns", mean());
+        record.add(prefix + "_p50_ns", percentile(50));
+        record.add(prefix + "_p90_ns", percentile(90));
+        record.add(prefix + "_p99_ns", percentile(99));
+        record.add(prefix + "_p999_ns", percentile(99.9));
+        record.add(prefix + "_max_ns", percentile(100));
+        auto [bounds, counts] = buckets();
+        record.add(prefix + "_histogram_bounds_ns", bounds);
+        record.add(prefix + "_histogram_counts", counts);
+    }
+
+    /**
+     * Prints the percentiles and the histogram in a human-readable format
+     */
+    void print(std::ostream& os, std::string const& title) {
+        os << title << " percentiles: p50=" << format(percentile(50))
+           << " p90=" << format(percentile(90)) << " p99=" << format(percentile(99))
+           << " p99.9=" << format(percentile(99.9)) << " max=" << format(percentile(100))
+           << std::endl;
+        auto [bounds, counts] = buckets();
+        for (size_t i = 0; i < bounds.size(); ++i) {
+            double lower_bound =
+                bounds[i] <= 1.0 ? 0.0 : bounds[i] / std::exp2(1.0 / m_buckets_per_octave);
+            double perc = 100.0 * counts[i] / m_samples.size();
+            os << "\t[" << format(lower_bound) << ", " << format(bounds[i]) << "): " << std::fixed
+               << std::setprecision(3) << perc << "%" << std::defaultfloat << std::endl;
+        }
+    }
+
+private:
+    inline void sort() {
+        if (!m_sorted) {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+    }
+
+    inline double upper_bound(double sample) const {
+        if (sample < 1.0) { return 1.0; }
+        double exponent = std::floor(std::log2(sample) * m_buckets_per_octave) + 1;
+        return std::exp2(exponent / m_buckets_per_octave);
+    }
+
+    static std::string format(double ns) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(ns < 10 ? 2 : (ns < 100 ? 1 : 0)) << ns << "ns";
+        return ss.str();
+    }
+
+    uint32_t m_buckets_per_octave;
+    std::vector<double> m_samples;
+    bool m_sorted = true;
+};
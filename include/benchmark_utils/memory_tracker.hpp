@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+/**
+ * Heap usage of the C++ allocations of the process, maintained by the replacements of the global
+ * `operator new` and `operator delete` defined in `src/memory_tracker.cpp`.
+ * Allocations of C code (e.g., `malloc` in CMPH) are not counted, but the resident set size
+ * covers them.
+ */
+namespace heap_usage {
+
+/**
+ * Starts counting the allocations, which are otherwise not tracked. It is meant to be called once,
+ * before the allocations to measure: freeing a block allocated before lowers the count.
+ * @return false if the platform cannot tell the size of a block (neither Linux nor macOS)
+ */
+bool enable();
+
+/**
+ * @return The number of bytes currently allocated through `operator new`
+ */
+int64_t current_bytes();
+
+/**
+ * @return The maximum of `current_bytes()` since the last call to `reset_peak`
+ */
+int64_t peak_bytes();
+
+/**
+ * Starts tracking the peak from the current heap usage
+ */
+void reset_peak();
+
+}  // namespace heap_usage
+
+/**
+ * Measures the peak memory used by a phase of the benchmark, as the increase of both the heap
+ * usage and the resident set size (RSS) over their values at `start`.
+ * The peak RSS is read from `VmHWM` of `/proc/self/status` after resetting it through
+ * `/proc/self/clear_refs`; when the reset is not permitted, the RSS is sampled by a background
+ * thread every `sampling_interval_ms` milliseconds instead, which may miss short-lived peaks.
+ * Note that the RSS does not shrink when the allocator keeps freed memory for later use, so the
+ * RSS delta of a phase following a larger one can be underestimated.
+ */
+class MemoryTracker {
+public:
+    MemoryTracker(uint32_t sampling_interval_ms = 1)
+        : m_sampling_interval_ms(sampling_interval_ms) {}
+
+    MemoryTracker(MemoryTracker const&) = delete;
+    MemoryTracker& operator=(MemoryTracker const&) = delete;
+
+    ~MemoryTracker() {
+        stop_sampling();
+    }
+
+    void start() {
+        stop_sampling();
+        m_start_rss = read_status_bytes("VmRSS:");
+        m_peak_rss = m_start_rss;
+        m_sampled = !reset_peak_rss();
+        if (m_sampled) {
+            m_stop_sampling = false;
+            m_sampler = std::thread([this] {
+                while (!m_stop_sampling.load(std::memory_order_relaxed)) {
+                    m_peak_rss = std::max(m_peak_rss.load(), read_status_bytes("VmRSS:"));
+                    std::this_thread::sleep_for(std::chrono::milliseconds(m_sampling_interval_ms));
+                }
+            });
+        }
+        m_start_heap = heap_usage::current_bytes();
+        heap_usage::reset_peak();
+    }
+
+    void stop() {
+        m_peak_heap = heap_usage::peak_bytes();
+        if (m_sampled) {
+            stop_sampling();
+            m_peak_rss = std::max(m_peak_rss.load(), read_status_bytes("VmRSS:"));
+        } else {
+            m_peak_rss = read_status_bytes("VmHWM:");
+        }
+    }
+
+    /**
+     * @return The peak increase of the heap usage between `start` and `stop`, in bytes
+     */
+    inline uint64_t peak_heap_bytes() const {
+        return std::max<int64_t>(m_peak_heap - m_start_heap, 0);
+    }
+
+    /**
+     * @return The peak increase of the resident set size between `start` and `stop`, in bytes
+     */
+    inline uint64_t peak_rss_bytes() const {
+        return std::max<int64_t>(m_peak_rss.load() - m_start_rss, 0);
+    }
+
+    /**
+     * @return true if the peak RSS was sampled rather than read from the kernel
+     */
+    inline bool sampled() const {
+        return m_sampled;
+    }
+
+private:
+    void stop_sampling() {
+        if (m_sampler.joinable()) {
+            m_stop_sampling = true;
+            m_sampler.join();
+        }
+    }
+
+    /**
+     * Resets `VmHWM` to the current RSS (supported since Linux 4.0)
+     */
+    static bool reset_peak_rss() {
+        std::ofstream os("/proc/self/clear_refs");
+        if (!os) return false;
+        os << "5";
+        os.flush();
+        return static_cast<bool>(os);
+    }
+
+    /**
+     * @return The value of the `/proc/self/status` field starting with `field`, in bytes
+     */
+    static int64_t read_status_bytes(std::string const& field) {
+        std::ifstream is("/proc/self/status");
+        std::string line;
+        while (std::getline(is, line)) {
+            if (line.compare(0, field.size(), field) == 0) {
+                return std::stoll(line.substr(field.size())) * 1024;  // the values are in kB
+            }
+        }
+        return 0;
+    }
+
+    uint32_t m_sampling_interval_ms;
+    bool m_sampled = false;
+    std::thread m_sampler;
+    std::atomic<bool> m_stop_sampling{false};
+    std::atomic<int64_t> m_peak_rss{0};
+    int64_t m_start_rss = 0;
+    int64_t m_start_heap = 0;
+    int64_t m_peak_heap = 0;
+};
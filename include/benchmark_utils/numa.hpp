@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Placement of the structure and of the keys in the NUMA test
+ */
+enum class NumaMode {
+    NONE,        // no NUMA test
+    BIND,        // one copy on a given node, looked up from each node in turn
+    INTERLEAVE,  // one copy interleaved over all the nodes, looked up from each node in turn
+    REPLICATE    // one copy per node, looked up concurrently from all the nodes
+};
+
+inline NumaMode parse_numa_mode(std::string const& name) {
+    if (name == "none") return NumaMode::NONE;
+    if (name == "bind") return NumaMode::BIND;
+    if (name == "interleave") return NumaMode::INTERLEAVE;
+    if (name == "replicate") return NumaMode::REPLICATE;
+    throw std::invalid_argument("Unknown NUMA mode `" + name +
+                                "`, expected one of `none`, `bind`, `interleave`, `replicate`");
+}
+
+inline const char* numa_mode_name(NumaMode mode) {
+    switch (mode) {
+        case NumaMode::NONE:
+            return "none";
+        case NumaMode::BIND:
+            return "bind";
+        case NumaMode::INTERLEAVE:
+            return "interleave";
+        case NumaMode::REPLICATE:
+            return "replicate";
+    }
+    return "";
+}
+
+/**
+ * @return The integers of a sysfs list, made of comma-separated integers or ranges of integers,
+ * e.g., `0-3,8-11`
+ */
+inline std::vector<int> parse_sysfs_list(std::string const& list) {
+    std::vector<int> values;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int value = first; value <= last; ++value) values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * @return The CPUs of each NUMA node, indexed by node ID, as reported by sysfs: the online nodes
+ * need not be numbered contiguously, and the nodes that are offline or have memory but no CPU get
+ * an empty list. A single node 0 with all the CPUs if the topology is unknown.
+ */
+inline std::vector<std::vector<int>> numa_node_cpus() {
+    std::vector<std::vector<int>> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (online >> list) {
+        for (int node : parse_sysfs_list(list)) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                               "/cpulist");
+            std::string cpus;
+            if (!(file >> cpus)) continue;  // an empty file: a node without CPUs
+            if (node >= int(nodes.size())) nodes.resize(node + 1);
+            nodes[node] = parse_sysfs_list(cpus);
+        }
+    }
+    if (std::none_of(nodes.begin(), nodes.end(), [](auto const& cpus) { return !cpus.empty(); })) {
+        nodes.assign(1, {});
+        unsigned num_cpus = std::thread::hardware_concurrency();
+        for (unsigned cpu = 0; cpu < std::max(num_cpus, 1u); ++cpu) nodes.back().push_back(cpu);
+    }
+    return nodes;
+}
+
+/**
+ * @return The IDs of the nodes of `node_cpus` with CPUs, in increasing order
+ */
+inline std::vector<int> numa_nodes_with_cpus(std::vector<std::vector<int>> const& node_cpus) {
+    std::vector<int> nodes;
+    for (int node = 0; node != int(node_cpus.size()); ++node) {
+        if (!node_cpus[node].empty()) nodes.push_back(node);
+    }
+    return nodes;
+}
+
+/**
+ * Restricts the CPUs that can run the calling thread to `cpus`
+ * @return Whether the affinity was changed
+ */
+inline bool pin_current_thread(std::vector<int> const& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Sets the memory policy of the calling thread, by the `set_mempolicy` system call, from its
+ * construction until its destruction: the pages first touched in the meantime (e.g., by filling
+ * newly allocated memory) are placed on the given nodes. The previous policy is replaced by the
+ * default one (local allocation) at the destruction.
+ */
+class ScopedMemoryPolicy {
+public:
+    // values of the `mode` argument of `set_mempolicy` (see `numaif.h`)
+    enum Policy { DEFAULT = 0, BIND = 2, INTERLEAVE = 3 };
+
+    ScopedMemoryPolicy(Policy policy, std::vector<int> const& nodes) {
+        m_applied = set(policy, nodes);
+    }
+
+    ScopedMemoryPolicy(ScopedMemoryPolicy const&) = delete;
+    ScopedMemoryPolicy& operator=(ScopedMemoryPolicy const&) = delete;
+
+    ~ScopedMemoryPolicy() {
+        if (m_applied) set(DEFAULT, {});
+    }
+
+    /**
+     * @return Whether the policy is in force (false if the system call failed, e.g., for lack of
+     * permissions or of NUMA support in the kernel)
+     */
+    inline bool applied() const {
+        return m_applied;
+    }
+
+private:
+    static bool set(Policy policy, std::vector<int> const& nodes) {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+        constexpr int bits_per_word = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(1, 0);
+        for (int node : nodes) {
+            if (node / bits_per_word >= int(mask.size())) mask.resize(node / bits_per_word + 1);
+            mask[node / bits_per_word] |= 1UL << (node % bits_per_word);
+        }
+        // the kernel reads `maxnode - 1` bits of the mask
+        unsigned long max_node = mask.size() * bits_per_word + 1;
+        return syscall(SYS_set_mempolicy, int(policy), policy == DEFAULT ? nullptr : mask.data(),
+                       policy == DEFAULT ? 0 : max_node) == 0;
+#else
+        return false;
+#endif
+    }
+
+    bool m_applied;
+};
+
+/**
+ * Allocator giving each array a fresh anonymous mapping, whose pages are placed by the memory
+ * policy of the thread first touching them (e.g., under a `ScopedMemoryPolicy`). The global
+ * allocator gives no such guarantee, since it can reuse pages already placed on another node.
+ */
+template <typename T>
+class MappedAllocator {
+public:
+    using value_type = T;
+
+    MappedAllocator() = default;
+
+    template <typename U>
+    MappedAllocator(MappedAllocator<U> const&) {}
+
+    T* allocate(size_t n) {
+#ifdef __linux__
+        void* ptr = mmap(nullptr, length(n), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1, 0);
+        if (ptr == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+#else
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+#endif
+    }
+
+    void deallocate(T* ptr, size_t n) {
+#ifdef __linux__
+        munmap(ptr, length(n));
+#else
+        (void)n;
+        ::operator delete(ptr);
+#endif
+    }
+
+    template <typename U>
+    bool operator==(MappedAllocator<U> const&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(MappedAllocator<U> const&) const {
+        return false;
+    }
+
+private:
+    static size_t length(size_t n) {
+        return std::max<size_t>(n * sizeof(T), 1);  // mmap rejects empty mappings
+    }
+};
+
+/**
+ * A vector backed by `MappedAllocator`
+ */
+template <typename T>
+using MappedVector = std::vector<T, MappedAllocator<T>>;
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Values taken by the parameters of the builders during a parameter sweep, parsed from a
+ * specification such as `bits_per_key=2:8:0.5;encoder=compact_compact,elias_fano`.
+ *
+ * Parameters are separated by semicolons, and each one lists comma-separated values or ranges
+ * `first:last[:step]`, where the step is added to the value (default: 1), or multiplies it when
+ * written `*factor` (e.g., `bucket_size=10:2000:*2`).
+ */
+class ParameterGrid {
+public:
+    ParameterGrid() = default;
+
+    explicit ParameterGrid(std::string const& spec) {
+        std::stringstream ss(spec);
+        std::string parameter;
+        while (std::getline(ss, parameter, ';')) {
+            if (parameter.empty()) continue;
+            size_t equal = parameter.find('=');
+            if (equal == std::string::npos || equal == 0 || equal + 1 == parameter.size()) {
+                throw std::invalid_argument("Malformed sweep parameter `" + parameter +
+                                            "`, expected `name=values`");
+            }
+            std::string name = parameter.substr(0, equal);
+            if (m_values.count(name)) {
+                throw std::invalid_argument("Sweep parameter `" + name + "` given twice");
+            }
+            std::vector<std::string>& values = m_values[name];
+            std::stringstream values_ss(parameter.substr(equal + 1));
+            std::string item;
+            while (std::getline(values_ss, item, ',')) {
+                if (item.find(':') == std::string::npos) {
+                    values.push_back(item);
+                } else {
+                    expand_range(name, item, values);
+                }
+            }
+            if (values.empty()) {
+                throw std::invalid_argument("Sweep parameter `" + name + "` has no values");
+            }
+        }
+    }
+
+    /**
+     * @return The values of the parameter `name`, or `defaults` if it is not in the grid
+     */
+    std::vector<std::string> values(std::string const& name,
+                                    std::vector<std::string> const& defaults) const {
+        auto it = m_values.find(name);
+        return it == m_values.end() ? defaults : it->second;
+    }
+
+    /**
+     * @return The numeric values of the parameter `name`, or `defaults` if it is not in the grid
+     */
+    std::vector<double> numbers(std::string const& name,
+                                std::vector<double> const& defaults) const {
+        auto it = m_values.find(name);
+        if (it == m_values.end()) return defaults;
+        std::vector<double> result;
+        for (auto const& value : it->second) result.push_back(parse_number(name, value));
+        return result;
+    }
+
+    /**
+     * @return The values of the parameter `name`, which must be non-negative integers, or
+     * `defaults` if it is not in the grid
+     */
+    std::vector<uint64_t> integers(std::string const& name,
+                                   std::vector<uint64_t> const& defaults) const {
+        auto it = m_values.find(name);
+        if (it == m_values.end()) return defaults;
+        std::vector<uint64_t> result;
+        for (auto const& value : it->second) {
+            double number = parse_number(name, value);
+            if (number < 0 || number != std::floor(number)) {
+                throw std::invalid_argument("Sweep parameter `" + name +
+                                            "` has a non-integer value `" + value + "`");
+            }
+            result.push_back(number);
+        }
+        return result;
+    }
+
+    /**
+     * @return The names of the parameters in the grid
+     */
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (auto const& entry : m_values) result.push_back(entry.first);
+        return result;
+    }
+
+private:
+    static double parse_number(std::string const& name, std::string const& value) {
+        size_t end = 0;
+        double result = std::nan("");
+        try {
+            result = std::stod(value, &end);
+        } catch (std::exception const&) { end = 0; }
+        if (end == 0 || end != value.size()) {
+            throw std::invalid_argument("Sweep parameter `" + name +
+                                        "` has a non-numeric value `" + value + "`");
+        }
+        return result;
+    }
+
+    static void expand_range(std::string const& name, std::string const& range,
+                             std::vector<std::string>& values) {
+        std::vector<std::string> parts;
+        std::stringstream ss(range);
+        std::string part;
+        while (std::getline(ss, part, ':')) parts.push_back(part);
+        if (parts.size() < 2 || parts.size() > 3) {
+            throw std::invalid_argument("Malformed range `" + range + "` of sweep parameter `" +
+                                        name + "`, expected `first:last[:step]`");
+        }
+        double first = parse_number(name, parts[0]);
+        double last = parse_number(name, parts[1]);
+        bool geometric = parts.size() == 3 && !parts[2].empty() && parts[2][0] == '*';
+        double step = 1.0;
+        if (parts.size() == 3) step = parse_number(name, geometric ? parts[2].substr(1) : parts[2]);
+        if (geometric ? (step <= 1 || first <= 0) : step <= 0) {
+            throw std::invalid_argument("The range `" + range + "` of sweep parameter `" + name +
+                                        "` does not progress");
+        }
+        const double tolerance = 1e-9 * std::max(std::abs(first), std::abs(last));
+        double value = first;
+        for (uint64_t i = 0; value <= last + tolerance; ++i) {
+            std::stringstream value_ss;
+            value_ss << value;
+            values.push_back(value_ss.str());
+            // compute each value from the first one, so that rounding errors do not accumulate
+            value = geometric ? first * std::pow(step, i + 1) : first + step * (i + 1);
+        }
+    }
+
+    std::map<std::string, std::vector<std::string>> m_values;
+};
+
+/**
+ * @return The indexes of the points that are not dominated by any other point, i.e., such that no
+ * other point is at least as good in every objective and strictly better in one. Each point is a
+ * vector of objectives to minimize; points with a NaN objective are excluded.
+ */
+inline std::vector<size_t> pareto_frontier(std::vector<std::vector<double>> const& points) {
+    auto is_valid = [](std::vector<double> const& point) {
+        for (double objective : point) {
+            if (std::isnan(objective)) return false;
+        }
+        return true;
+    };
+    auto dominates = [](std::vector<double> const& a, std::vector<double> const& b) {
+        bool strictly_better = false;
+        for (size_t i = 0; i != a.size(); ++i) {
+            if (a[i] > b[i]) return false;
+            if (a[i] < b[i]) strictly_better = true;
+        }
+        return strictly_better;
+    };
+    std::vector<size_t> frontier;
+    for (size_t i = 0; i != points.size(); ++i) {
+        if (!is_valid(points[i])) continue;
+        bool dominated = false;
+        for (size_t j = 0; j != points.size() && !dominated; ++j) {
+            dominated = j != i && is_valid(points[j]) && dominates(points[j], points[i]);
+        }
+        if (!dominated) frontier.push_back(i);
+    }
+    return frontier;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Hardware performance counters of the calling process, read through the Linux `perf_event_open`
+ * interface. Each event is opened independently, so that the events unsupported by the processor
+ * (or forbidden by `perf_event_paranoid`) are reported as unavailable without affecting the other
+ * ones. Only user-space events are counted, including those of the threads spawned while counting.
+ * Counts are scaled when the kernel multiplexes the counters, and accumulated over all the
+ * `start`/`stop` intervals since the last `reset`.
+ */
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+    PerfCounters() {
+        for (int event = 0; event != NUM_EVENTS; ++event) {
+            m_fds[event] = open_event(static_cast<Event>(event));
+        }
+        reset();
+    }
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : m_fds) {
+            if (fd != -1) close(fd);
+        }
+#endif
+    }
+
+    static const char* name(Event event) {
+        static const char* names[] = {"cycles", "instructions", "llc_misses", "dtlb_misses",
+                                      "branch_misses"};
+        return names[event];
+    }
+
+    inline bool available(Event event) const {
+        return m_fds[event] != -1;
+    }
+
+    /**
+     * @return true if at least one event can be counted
+     */
+    bool any_available() const {
+        for (int event = 0; event != NUM_EVENTS; ++event) {
+            if (available(static_cast<Event>(event))) return true;
+        }
+        return false;
+    }
+
+    void reset() {
+        for (int event = 0; event != NUM_EVENTS; ++event) {
+            m_values[event] = available(static_cast<Event>(event)) ? 0.0 : std::nan("");
+        }
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : m_fds) {
+            if (fd != -1) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+        for (int fd : m_fds) {
+            if (fd != -1) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int fd : m_fds) {
+            if (fd != -1) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for (int event = 0; event != NUM_EVENTS; ++event) {
+            if (m_fds[event] == -1) continue;
+            uint64_t data[3];  // value, time enabled, time running
+            if (read(m_fds[event], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+                m_values[event] = std::nan("");  // unreadable or never scheduled
+                continue;
+            }
+            m_values[event] += static_cast<double>(data[0]) * data[1] / data[2];
+        }
+#endif
+    }
+
+    /**
+     * @return The count of `event` accumulated since the last `reset`, or NaN if the event is
+     * unavailable
+     */
+    inline double value(Event event) const {
+        return m_values[event];
+    }
+
+private:
+    static int open_event(Event event) {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        switch (event) {
+            case CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case LLC_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case BRANCH_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            default:
+                return -1;
+        }
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)event;
+        return -1;
+#endif
+    }
+
+    int m_fds[NUM_EVENTS];
+    double m_values[NUM_EVENTS];
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../huge_page_allocator.hpp"
+#include "../key_file.hpp"
+#include "../key_span.hpp"
+
+/**
+ * Order in which the keys are looked up during the lookup test
+ */
+enum class QueryDistribution {
+    SEQUENTIAL,  // the keys in the order they are stored
+    UNIFORM,     // keys drawn uniformly at random, with replacement
+    ZIPF,        // keys drawn from a Zipfian distribution, with replacement
+    SORTED,      // the keys sorted by value
+    TRACE        // the keys listed in a trace file
+};
+
+struct QueryWorkload {
+    QueryDistribution distribution = QueryDistribution::SEQUENTIAL;
+    uint64_t num_queries = 0;  // 0 = as many queries as keys (ignored by `sequential`, `trace`)
+    double zipf_skew = 1.0;
+    std::string trace_filename;
+
+    static QueryDistribution parse_distribution(std::string const& name) {
+        if (name == "sequential") return QueryDistribution::SEQUENTIAL;
+        if (name == "uniform") return QueryDistribution::UNIFORM;
+        if (name == "zipf") return QueryDistribution::ZIPF;
+        if (name == "sorted") return QueryDistribution::SORTED;
+        if (name == "trace") return QueryDistribution::TRACE;
+        throw std::invalid_argument("Unknown query distribution `" + name +
+                                    "`, expected one of `sequential`, `uniform`, `zipf`, "
+                                    "`sorted`, `trace`");
+    }
+
+    std::string name() const {
+        std::stringstream ss;
+        switch (distribution) {
+            case QueryDistribution::SEQUENTIAL:
+                ss << "sequential";
+                break;
+            case QueryDistribution::UNIFORM:
+                ss << "uniform";
+                break;
+            case QueryDistribution::ZIPF:
+                ss << "zipf(s=" << zipf_skew << ")";
+                break;
+            case QueryDistribution::SORTED:
+                ss << "sorted";
+                break;
+            case QueryDistribution::TRACE:
+                ss << "trace(" << trace_filename << ")";
+                break;
+        }
+        return ss.str();
+    }
+};
+
+/**
+ * Forward iterator over the keys at a sequence of positions, used to pass a slice of the query
+ * sequence to `lookup_batch` without copying the keys
+ */
+template <typename T>
+class IndirectIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    IndirectIterator(const T* keys, const uint64_t* positions)
+        : m_keys(keys), m_positions(positions) {}
+
+    inline reference operator*() const {
+        return m_keys[*m_positions];
+    }
+
+    inline IndirectIterator& operator++() {
+        ++m_positions;
+        return *this;
+    }
+
+    inline bool operator==(IndirectIterator const& other) const {
+        return m_positions == other.m_positions;
+    }
+
+    inline bool operator!=(IndirectIterator const& other) const {
+        return m_positions != other.m_positions;
+    }
+
+private:
+    const T* m_keys;
+    const uint64_t* m_positions;
+};
+
+/**
+ * Samples integers in [1, n] with probability proportional to 1/k^s, in constant time and space,
+ * by the rejection-inversion method of Hörmann and Derflinger ("Rejection-inversion to generate
+ * variates from monotone discrete distributions", ACM TOMACS 1996).
+ */
+class ZipfDistribution {
+public:
+    ZipfDistribution(uint64_t n, double s) : m_n(n), m_s(s) {
+        if (n == 0) { throw std::invalid_argument("`n` must be greater than zero"); }
+        if (s <= 0) { throw std::invalid_argument("the Zipfian skew must be greater than zero"); }
+        m_h_integral_x1 = h_integral(1.5) - 1.0;
+        m_h_integral_n = h_integral(n + 0.5);
+        m_threshold = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+    }
+
+    template <typename Generator>
+    uint64_t operator()(Generator& generator) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        while (true) {
+            double u = m_h_integral_n + uniform(generator) * (m_h_integral_x1 - m_h_integral_n);
+            double x = h_integral_inverse(u);
+            double k = std::floor(x + 0.5);
+            k = std::min(std::max(k, 1.0), static_cast<double>(m_n));
+            if (k - x <= m_threshold || u >= h_integral(k + 0.5) - h(k)) {
+                return static_cast<uint64_t>(k);
+            }
+        }
+    }
+
+private:
+    inline double h(double x) const {
+        return std::exp(-m_s * std::log(x));
+    }
+
+    inline double h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1.0 - m_s) * log_x) * log_x;
+    }
+
+    inline double h_integral_inverse(double x) const {
+        double t = x * (1.0 - m_s);
+        if (t < -1.0) t = -1.0;
+        return std::exp(helper1(t) * x);
+    }
+
+    // log(1 + x) / x, accurate also for values of x close to zero
+    static inline double helper1(double x) {
+        if (std::abs(x) > 1e-8) return std::log1p(x) / x;
+        return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    // (exp(x) - 1) / x, accurate also for values of x close to zero
+    static inline double helper2(double x) {
+        if (std::abs(x) > 1e-8) return std::expm1(x) / x;
+        return 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+
+    uint64_t m_n;
+    double m_s;
+    double m_h_integral_x1, m_h_integral_n, m_threshold;
+};
+
+/**
+ * Hash of the keys matched against a trace, since `std::hash` is not specialized for 128-bit
+ * integers in ISO C++ mode
+ */
+template <typename T>
+struct TraceKeyHash : std::hash<T> {};
+
+template <>
+struct TraceKeyHash<__uint128_t> {
+    inline size_t operator()(__uint128_t key) const {
+        return std::hash<uint64_t>()(uint64_t(key) ^ uint64_t(key >> 64) * 0x9E3779B97F4A7C15);
+    }
+};
+
+/**
+ * Creates the sequence of positions of the keys to look up according to `workload`.
+ * An empty sequence stands for the `sequential` distribution, which scans the keys in place.
+ * The sequence is allocated in the default page mode, as the keys (see --huge_pages).
+ * @param num_missing Set to the number of trace entries that are not keys of the set (skipped)
+ */
+template <typename T>
+mphf::huge_page_vector<uint64_t> create_queries(KeySpan<T> keys, QueryWorkload const& workload,
+                                                uint64_t seed, uint64_t& num_missing) {
+    const uint64_t num_keys = keys.size();
+    const uint64_t num_queries = workload.num_queries != 0 ? workload.num_queries : num_keys;
+    std::mt19937_64 generator(seed);
+    mphf::huge_page_vector<uint64_t> queries;
+    num_missing = 0;
+
+    switch (workload.distribution) {
+        case QueryDistribution::SEQUENTIAL:
+            break;
+
+        case QueryDistribution::UNIFORM: {
+            std::uniform_int_distribution<uint64_t> distribution(0, num_keys - 1);
+            queries.resize(num_queries);
+            for (auto& query : queries) { query = distribution(generator); }
+            break;
+        }
+
+        case QueryDistribution::ZIPF: {
+            // the ranks are scattered over the keys by the bijection `(a * rank + b) mod n`, so
+            // that the most popular keys are not stored next to each other
+            ZipfDistribution distribution(num_keys, workload.zipf_skew);
+            uint64_t a = generator() % num_keys;
+            while (std::gcd(a, num_keys) != 1) { a = (a + 1) % num_keys; }
+            uint64_t b = generator() % num_keys;
+            queries.resize(num_queries);
+            for (auto& query : queries) {
+                uint64_t rank = distribution(generator) - 1;
+                query = static_cast<uint64_t>((static_cast<__uint128_t>(a) * rank + b) % num_keys);
+            }
+            break;
+        }
+
+        case QueryDistribution::SORTED:
+            queries.resize(num_keys);
+            std::iota(queries.begin(), queries.end(), 0);
+            std::sort(queries.begin(), queries.end(),
+                      [&keys](uint64_t i, uint64_t j) { return keys[i] < keys[j]; });
+            break;
+
+        case QueryDistribution::TRACE: {
+            std::ifstream is(workload.trace_filename);
+            if (!is) {
+                throw std::runtime_error("Unable to open the query trace `" +
+                                         workload.trace_filename + "`");
+            }
+            std::unordered_map<T, uint64_t, TraceKeyHash<T>> positions;
+            positions.reserve(num_keys);
+            for (uint64_t i = 0; i < num_keys; ++i) { positions.emplace(keys[i], i); }
+            std::string line;
+            for (uint64_t line_number = 1; std::getline(is, line); ++line_number) {
+                T key;
+                if constexpr (std::is_same_v<T, std::string> ||
+                              std::is_same_v<T, std::string_view>) {
+                    key = line;  // a view of the line is only used for the lookup below
+                } else {
+                    try {
+                        key = parse_integer_key<T>(line);
+                    } catch (std::invalid_argument const& e) {
+                        throw std::invalid_argument("Malformed line " +
+                                                    std::to_string(line_number) +
+                                                    " of the query trace: " + e.what());
+                    }
+                }
+                auto it = positions.find(key);
+                if (it == positions.end()) {
+                    ++num_missing;
+                } else {
+                    queries.push_back(it->second);
+                }
+            }
+            if (queries.empty()) {
+                throw std::runtime_error("The query trace does not contain any key of the set");
+            }
+            break;
+        }
+    }
+    return queries;
+}
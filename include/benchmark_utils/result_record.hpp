@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A flat and ordered list of named values describing the outcome of a test.
+ */
+class ResultRecord {
+public:
+    enum class FieldType { STRING, NUMBER, BOOLEAN, ARRAY };
+
+    struct Field {
+        std::string name;
+        FieldType type;
+        std::string value;                // textual representation (unused for arrays)
+        double number;                    // numeric value (NaN for non-numeric fields)
+        std::vector<std::string> values;  // textual representation of the array elements
+    };
+
+    void add(std::string const& name, std::string const& value) {
+        set({name, FieldType::STRING, value, std::nan(""), {}});
+    }
+
+    void add(std::string const& name, const char* value) {
+        add(name, std::string(value));
+    }
+
+    void add(std::string const& name, bool value) {
+        set({name, FieldType::BOOLEAN, value ? "true" : "false", value ? 1.0 : 0.0, {}});
+    }
+
+    template <typename T>
+    std::enable_if_t<std::is_arithmetic_v<T>> add(std::string const& name, T value) {
+        set({name, FieldType::NUMBER, format_number(value), static_cast<double>(value), {}});
+    }
+
+    template <typename T>
+    void add(std::string const& name, std::vector<T> const& values) {
+        Field field{name, FieldType::ARRAY, "", std::nan(""), {}};
+        field.values.reserve(values.size());
+        for (auto value : values) { field.values.push_back(format_number(value)); }
+        set(std::move(field));
+    }
+
+    /**
+     * Appends all the fields of `other`, replacing the ones with the same name
+     */
+    void add(ResultRecord const& other) {
+        for (auto const& field : other.m_fields) { set(field); }
+    }
+
+    inline bool contains(std::string const& name) const {
+        return find(name) != nullptr;
+    }
+
+    /**
+     * @return The numeric value of the field `name`, or NaN if it is missing or not numeric
+     */
+    inline double number(std::string const& name) const {
+        const Field* field = find(name);
+        return field ? field->number : std::nan("");
+    }
+
+    /**
+     * @return The textual value of the field `name`, or an empty string if it is missing
+     */
+    inline std::string text(std::string const& name) const {
+        const Field* field = find(name);
+        return field ? field->value : "";
+    }
+
+    inline std::vector<Field> const& fields() const {
+        return m_fields;
+    }
+
+private:
+    template <typename T>
+    static std::string format_number(T value) {
+        if constexpr (std::is_integral_v<T>) {
+            return std::to_string(value);
+        } else {
+            if (!std::isfinite(value)) { return ""; }
+            std::stringstream ss;
+            ss << std::setprecision(10) << value;
+            return ss.str();
+        }
+    }
+
+    void set(Field field) {
+        for (auto& existing : m_fields) {
+            if (existing.name == field.name) {
+                existing = std::move(field);
+                return;
+            }
+        }
+        m_fields.push_back(std::move(field));
+    }
+
+    const Field* find(std::string const& name) const {
+        for (auto const& field : m_fields) {
+            if (field.name == name) { return &field; }
+        }
+        return nullptr;
+    }
+
+    std::vector<Field> m_fields;
+};
+
+enum class OutputFormat { TEXT, JSON, CSV };
+
+/**
+ * Writes result records in a machine-readable format.
+ * JSON records are written one per line, while CSV records are preceded by a header line that is
+ * repeated every time the set of fields changes. The TEXT format writes nothing, as the tests
+ * already print a human-readable report on the standard error.
+ */
+class ResultWriter {
+public:
+    ResultWriter(std::ostream& os, OutputFormat format) : m_os(os), m_format(format) {}
+
+    static OutputFormat parse_format(std::string const& name) {
+        if (name == "text") return OutputFormat::TEXT;
+        if (name == "json") return OutputFormat::JSON;
+        if (name == "csv") return OutputFormat::CSV;
+        throw std::invalid_argument("Unknown output format `" + name +
+                                    "`, expected one of `text`, `json`, `csv`");
+    }
+
+    inline OutputFormat format() const {
+        return m_format;
+    }
+
+    void write(ResultRecord const& record) {
+        switch (m_format) {
+            case OutputFormat::TEXT:
+                break;
+            case OutputFormat::JSON:
+                write_json(record);
+                break;
+            case OutputFormat::CSV:
+                write_csv(record);
+                break;
+        }
+    }
+
+private:
+    void write_json(ResultRecord const& record) {
+        m_os << "{";
+        bool is_first = true;
+        for (auto const& field : record.fields()) {
+            if (!is_first) m_os << ",";
+            is_first = false;
+            m_os << json_string(field.name) << ":";
+            switch (field.type) {
+                case ResultRecord::FieldType::STRING:
+                    m_os << json_string(field.value);
+                    break;
+                case ResultRecord::FieldType::NUMBER:
+                case ResultRecord::FieldType::BOOLEAN:
+                    m_os << (field.value.empty() ? "null" : field.value);
+                    break;
+                case ResultRecord::FieldType::ARRAY:
+                    m_os << "[";
+                    for (size_t i = 0; i < field.values.size(); ++i) {
+                        if (i != 0) m_os << ",";
+                        m_os << (field.values[i].empty() ? "null" : field.values[i]);
+                    }
+                    m_os << "]";
+                    break;
+            }
+        }
+        m_os << "}" << std::endl;
+    }
+
+    void write_csv(ResultRecord const& record) {
+        std::vector<std::string> header;
+        header.reserve(record.fields().size());
+        for (auto const& field : record.fields()) { header.push_back(field.name); }
+        if (header != m_csv_header) {
+            m_csv_header = header;
+            for (size_t i = 0; i < header.size(); ++i) {
+                if (i != 0) m_os << ",";
+                m_os << csv_string(header[i]);
+            }
+            m_os << std::endl;
+        }
+
+        bool is_first = true;
+        for (auto const& field : record.fields()) {
+            if (!is_first) m_os << ",";
+            is_first = false;
+            if (field.type == ResultRecord::FieldType::ARRAY) {
+                // array elements are separated by semicolons within a single cell
+                std::string joined;
+                for (size_t i = 0; i < field.values.size(); ++i) {
+                    if (i != 0) joined += ";";
+                    joined += field.values[i];
+                }
+                m_os << joined;
+            } else if (field.type == ResultRecord::FieldType::STRING) {
+                m_os << csv_string(field.value);
+            } else {
+                m_os << field.value;
+            }
+        }
+        m_os << std::endl;
+    }
+
+    static std::string json_string(std::string const& s) {
+        std::stringstream ss;
+        ss << '"';
+        for (char c : s) {
+            switch (c) {
+                case '"':
+                    ss << "\\\"";
+                    break;
+                case '\\':
+                    ss << "\\\\";
+                    break;
+                case '\n':
+                    ss << "\\n";
+                    break;
+                case '\t':
+                    ss << "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        ss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                           << static_cast<int>(c) << std::dec;
+                    } else {
+                        ss << c;
+                    }
+            }
+        }
+        ss << '"';
+        return ss.str();
+    }
+
+    static std::string csv_string(std::string const& s) {
+        if (s.find_first_of(",\"\n") == std::string::npos) { return s; }
+        std::string quoted = "\"";
+        for (char c : s) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        quoted += '"';
+        return quoted;
+    }
+
+    std::ostream& m_os;
+    OutputFormat m_format;
+    std::vector<std::string> m_csv_header;
+};
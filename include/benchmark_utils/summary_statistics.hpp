@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "result_record.hpp"
+
+/**
+ * Summary of a sample of measurements (e.g., the construction times over several seeds): median,
+ * extremes, mean, sample standard deviation and the 95% confidence interval of the mean, computed
+ * with the Student's t-distribution.
+ */
+struct SummaryStatistics {
+    SummaryStatistics(std::vector<double> samples) {
+        count = samples.size();
+        if (count == 0) return;
+        std::sort(samples.begin(), samples.end());
+        min = samples.front();
+        max = samples.back();
+        median = count % 2 == 1 ? samples[count / 2]
+                                : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+        double sum = 0;
+        for (double sample : samples) sum += sample;
+        mean = sum / count;
+        if (count < 2) return;
+        double squares = 0;
+        for (double sample : samples) squares += (sample - mean) * (sample - mean);
+        stddev = std::sqrt(squares / (count - 1));
+        double half_width = t_quantile_975(count - 1) * stddev / std::sqrt(count);
+        ci95_low = mean - half_width;
+        ci95_high = mean + half_width;
+    }
+
+    /**
+     * Adds the statistics to `record`, prefixing each field by `prefix`
+     */
+    void report(ResultRecord& record, std::string const& prefix) const {
+        record.add(prefix + "_median", median);
+        record.add(prefix + "_min", min);
+        record.add(prefix + "_max", max);
+        record.add(prefix + "_mean", mean);
+        record.add(prefix + "_stddev", stddev);
+        record.add(prefix + "_ci95_low", ci95_low);
+        record.add(prefix + "_ci95_high", ci95_high);
+    }
+
+    /**
+     * Prints the statistics in a human-readable format, after multiplying them by `scale`
+     */
+    void print(std::ostream& os, std::string const& title, std::string const& unit,
+               double scale = 1.0) const {
+        auto format = [&](double value) {
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(3) << value * scale;
+            return ss.str();
+        };
+        os << title << ": median " << format(median) << unit << ", min " << format(min) << unit
+           << ", max " << format(max) << unit << ", stddev " << format(stddev) << unit;
+        if (!std::isnan(ci95_low)) {
+            os << ", 95% CI of the mean [" << format(ci95_low) << ", " << format(ci95_high) << "]"
+               << unit;
+        }
+        os << std::endl;
+    }
+
+    uint64_t count = 0;
+    double median = std::nan(""), min = std::nan(""), max = std::nan(""), mean = std::nan("");
+    double stddev = std::nan(""), ci95_low = std::nan(""), ci95_high = std::nan("");
+
+private:
+    /**
+     * @return The 97.5th percentile of the t-distribution with `df` degrees of freedom
+     */
+    static double t_quantile_975(uint64_t df) {
+        static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                       2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                       2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                       2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+        if (df <= 30) return table[df - 1];
+        // Cornish-Fisher expansion around the normal quantile, accurate to 1e-3 beyond 30
+        const double z = 1.959964, z3 = z * z * z, z5 = z3 * z * z;
+        return z + (z3 + z) / (4.0 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96.0 * df * df);
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Metric minimized by the tuner among the configurations meeting the budget
+ */
+enum class TuningObjective { LOOKUP, CONSTRUCTION, SPACE };
+
+inline TuningObjective parse_tuning_objective(std::string const& name) {
+    if (name == "lookup") return TuningObjective::LOOKUP;
+    if (name == "construction") return TuningObjective::CONSTRUCTION;
+    if (name == "space") return TuningObjective::SPACE;
+    throw std::invalid_argument("Unknown tuning objective `" + name +
+                                "`, expected one of `lookup`, `construction`, `space`");
+}
+
+/**
+ * Constraints and objective of the tuner
+ */
+struct TuningBudget {
+    double max_bits_per_key = std::numeric_limits<double>::infinity();
+    double max_construction_seconds = std::numeric_limits<double>::infinity();
+    uint64_t target_num_keys = 0;    // number of keys the budget refers to (0 = all the keys)
+    uint64_t sample_size = 1000000;  // keys of the largest trial
+    TuningObjective objective = TuningObjective::LOOKUP;
+    bool full_build = false;  // test the best configuration on all the keys
+};
+
+/**
+ * Growth of a metric with the number of keys
+ */
+enum class Growth {
+    CONSTANT,
+    LOGARITHMIC,  // log n
+    LINEAR,       // n
+    LINEARITHMIC  // n log n
+};
+
+/**
+ * @return The factor by which a metric growing as `growth` changes from `x1` to `x` keys
+ */
+inline double growth_factor(Growth growth, double x1, double x) {
+    switch (growth) {
+        case Growth::CONSTANT:
+            return 1;
+        case Growth::LOGARITHMIC:
+            return std::log2(std::max(x, 2.0)) / std::log2(std::max(x1, 2.0));
+        case Growth::LINEAR:
+            return x / x1;
+        case Growth::LINEARITHMIC:
+            return x / x1 * growth_factor(Growth::LOGARITHMIC, x1, x);
+    }
+    return 1;
+}
+
+/**
+ * Predicts the value of a metric for `x` keys from its values `ys` measured for the increasing
+ * numbers of keys `xs`, assuming that it grows as a power of the number of keys. The exponent is
+ * fitted by least squares on the logarithms of all the measures. If the measures do not increase
+ * with the number of keys (e.g., noisy lookup times), no trend can be fitted and the metric is
+ * assumed to grow as `max_growth`, so that a jump at the full size (e.g., when the structure
+ * outgrows a cache level) is not missed. Otherwise, the prediction from the largest measure is
+ * bounded by `min_growth` and `max_growth`, so that the noise of small trials can neither make it
+ * decrease below the expected growth nor explode.
+ */
+inline double extrapolate(std::vector<double> const& xs, std::vector<double> const& ys, double x,
+                          Growth min_growth, Growth max_growth) {
+    if (xs.empty() || xs.size() != ys.size()) {
+        throw std::invalid_argument("The extrapolation requires as many sizes as measures");
+    }
+    const double x1 = xs.back(), y1 = ys.back();
+    const double min_factor = growth_factor(min_growth, x1, x);
+    const double max_factor = growth_factor(max_growth, x1, x);
+    bool increasing = xs.size() > 1;
+    for (size_t i = 1; i < xs.size(); ++i) {
+        increasing &= xs[i] > xs[i - 1] && ys[i] >= ys[i - 1] && ys[i - 1] > 0;
+    }
+    if (!increasing) return y1 * max_factor;
+
+    double mean_x = 0, mean_y = 0;
+    for (size_t i = 0; i != xs.size(); ++i) {
+        mean_x += std::log(xs[i]) / xs.size();
+        mean_y += std::log(ys[i]) / xs.size();
+    }
+    double covariance = 0, variance = 0;
+    for (size_t i = 0; i != xs.size(); ++i) {
+        covariance += (std::log(xs[i]) - mean_x) * (std::log(ys[i]) - mean_y);
+        variance += (std::log(xs[i]) - mean_x) * (std::log(xs[i]) - mean_x);
+    }
+    const double factor = std::pow(x / x1, covariance / variance);
+    return y1 * std::clamp(factor, std::min(min_factor, max_factor),
+                           std::max(min_factor, max_factor));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mphf {
+
+/**
+ * Events counted by a builder during a construction (e.g., the restarts of FCH) and the time spent
+ * in each of its phases, collected when a pointer to an instance is passed to `Builder::build`.
+ * Counts and times are accumulated over all the constructions sharing the same instance, and
+ * phases keep the order in which they are first reported.
+ */
+struct BuildStats {
+    inline void add_phase(std::string const& phase, double seconds) {
+        for (auto& [name, total] : m_phases) {
+            if (name == phase) {
+                total += seconds;
+                return;
+            }
+        }
+        m_phases.emplace_back(phase, seconds);
+    }
+
+    /**
+     * @return The name of each phase and the time spent in it, in seconds
+     */
+    inline std::vector<std::pair<std::string, double>> const& phases() const {
+        return m_phases;
+    }
+
+    inline void count(std::string const& event, uint64_t amount = 1) {
+        m_counts[event] += amount;
+    }
+
+    inline uint64_t get(std::string const& event) const {
+        auto it = m_counts.find(event);
+        return it == m_counts.end() ? 0 : it->second;
+    }
+
+    inline std::map<std::string, uint64_t> const& counts() const {
+        return m_counts;
+    }
+
+    inline void merge(BuildStats const& other) {
+        for (auto const& [event, amount] : other.m_counts) { count(event, amount); }
+        for (auto const& [phase, seconds] : other.m_phases) { add_phase(phase, seconds); }
+    }
+
+    inline void clear() {
+        m_counts.clear();
+        m_phases.clear();
+    }
+
+private:
+    std::map<std::string, uint64_t> m_counts;
+    std::vector<std::pair<std::string, double>> m_phases;
+};
+
+}  // namespace mphf
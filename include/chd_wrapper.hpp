@@ -1,7 +1,14 @@
 #pragma once
 
+#include <cstdlib>
 #include <fcntl.h>
 #include <sstream>
+#include <string_view>
+
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "serialization.hpp"
+#include "utils.hpp"
 
 #include "../external/cmph/src/cmph.h"
 #include "../external/cmph/src/cmph_structs.h"
@@ -21,16 +28,18 @@ struct CHDWrapper {
         }
 
         template <typename T>
-        CHDWrapper build(const std::vector<T>& keys, uint64_t seed = 0,
-                         bool verbose = false) const {
+        CHDWrapper build(KeySpan<T> keys, uint64_t seed = 0,
+                         bool verbose = false, BuildStats* stats = nullptr) const {
             CHDWrapper chd_wrapper;
-            build(chd_wrapper, keys, seed, verbose);
+            build(chd_wrapper, keys, seed, verbose, stats);
             return chd_wrapper;
         }
 
         template <typename T>
-        void build(CHDWrapper& chd_wrapper, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(CHDWrapper& chd_wrapper, KeySpan<T> keys, uint64_t seed = 0,
+                   [[maybe_unused]] bool verbose = false, BuildStats* stats = nullptr) const {
+            Chrono chrono;
+            chrono.start();
             // Source of keys
             cmph_vector_adapter adapter(keys);
             cmph_config_t* config = cmph_config_new(&adapter);
@@ -41,32 +50,72 @@ struct CHDWrapper {
                 cmph_destroy(chd_wrapper.m_chd);
                 chd_wrapper.m_chd = nullptr;
             }
-            chd_wrapper.m_chd = cmph_new(config);
+            {
+                RandSeeding seeding(seed);
+                chd_wrapper.m_chd = cmph_new(config);
+            }
             cmph_config_destroy(config);
+            if (!chd_wrapper.m_chd) { throw std::runtime_error("CHD construction failed"); }
+            chrono.stop();
+            if (stats) stats->add_phase("construction", chrono.elapsed_time());
         }
 
         std::string name() const {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return 1;
+        }
+
+        /**
+         * @return true if the structure depends on the seed passed to `build`
+         */
+        bool seeded() const {
+            return true;
+        }
+
     private:
+        /**
+         * CMPH has no setting for the seed: it draws the seeds of its hash functions from the
+         * global `rand` generator, which is seeded with `seed + 1` (folded to 32 bits) during the
+         * lifetime of the scope, so that the seed 0 gives the structures built without seeding,
+         * as `rand` starts as if seeded with 1. The state of `rand` cannot be saved, so on exit
+         * it is reseeded with a value drawn from it on entry: the callers of `rand` see the same
+         * sequence whatever the seed, although not the one they would have seen without the
+         * construction. As `rand` is global, CHD structures must not be built concurrently.
+         */
+        struct RandSeeding {
+            RandSeeding(uint64_t seed) : m_next(rand()) {
+                srand(static_cast<unsigned>(seed ^ (seed >> 32)) + 1);
+            }
+            ~RandSeeding() {
+                srand(static_cast<unsigned>(m_next));
+            }
+            RandSeeding(RandSeeding const&) = delete;
+            RandSeeding& operator=(RandSeeding const&) = delete;
+
+        private:
+            int m_next;
+        };
+
         template <typename T>
         struct cmph_vector_adapter : cmph_io_adapter_t {
-            cmph_vector_adapter(std::vector<T> const& keys) {
+            cmph_vector_adapter(KeySpan<T> keys) {
                 data = (void*)this;
                 nkeys = keys.size();
                 read = _read;
                 dispose = _dispose;
                 rewind = _rewind;
 
-                m_keys = &keys;
+                m_keys = keys;
                 m_position = 0;
             }
 
         private:
             static int _read(void* data, char** key, cmph_uint32* len) {
                 cmph_vector_adapter* adapter = (cmph_vector_adapter*)data;
-                *len = input_adapter(adapter->m_keys->operator[](adapter->m_position++), key);
+                *len = input_adapter(adapter->m_keys[adapter->m_position++], key);
                 return *len;
             }
 
@@ -77,7 +126,7 @@ struct CHDWrapper {
                 adapter->m_position = 0;
             }
 
-            const std::vector<T>* m_keys;
+            KeySpan<T> m_keys;
             uint64_t m_position;
         };
 
@@ -92,17 +141,31 @@ struct CHDWrapper {
         }
     }
 
+    // `cmph_search` only reads the structure, so concurrent lookups are safe
     template <typename T>
-    inline uint64_t operator()(const T& key) {  // this should be const but `lookup` is not const
+    inline uint64_t operator()(const T& key) const {
         char* char_ptr_key;
         cmph_uint32 size = input_adapter(key, &char_ptr_key);
         return cmph_search(m_chd, char_ptr_key, size);
     }
 
-    inline size_t num_bits() {  // this should be const but `totalBitSize` is not const
+    inline size_t num_bits() const {
         return cmph_packed_size(m_chd) * 8;
     }
 
+    void save(std::ostream& os) const {
+        save_through_file(os, [&](FILE* file) { cmph_dump(m_chd, file); });
+    }
+
+    void load(std::istream& is) {
+        if (m_chd) {
+            cmph_destroy(m_chd);
+            m_chd = nullptr;
+        }
+        load_through_file(is, [&](FILE* file) { m_chd = cmph_load(file); });
+        if (!m_chd) throw std::runtime_error("Unable to load the CHD structure");
+    }
+
 private:
     template <typename T>
     static inline cmph_uint32 input_adapter(const T& key, char** char_ptr_key) {
@@ -116,6 +179,11 @@ private:
         return key.size();
     }
 
+    static inline cmph_uint32 input_adapter(std::string_view key, char** char_ptr_key) {
+        *char_ptr_key = (char*)key.data();
+        return key.size();
+    }
+
     cmph_t* m_chd = nullptr;
 };
 
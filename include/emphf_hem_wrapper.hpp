@@ -2,6 +2,11 @@
 
 #include <fcntl.h>
 #include <sstream>
+#include <string_view>
+
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "utils.hpp"
 
 #include "../external/emphf/base_hash.hpp"
 #include "../external/emphf/mphf_hem.hpp"
@@ -16,34 +21,51 @@ struct EMPHFHEMWrapper {
         }
 
         template <typename T>
-        EMPHFHEMWrapper build(const std::vector<T>& keys, uint64_t seed = 0,
-                              bool verbose = false) const {
+        EMPHFHEMWrapper build(KeySpan<T> keys, uint64_t seed = 0,
+                              bool verbose = false, BuildStats* stats = nullptr) const {
             EMPHFHEMWrapper emphf_wrapper;
-            build(emphf_wrapper, keys, seed, verbose);
+            build(emphf_wrapper, keys, seed, verbose, stats);
             return emphf_wrapper;
         }
 
         template <typename T>
-        void build(EMPHFHEMWrapper& emphf_wrapper, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(EMPHFHEMWrapper& emphf_wrapper, KeySpan<T> keys,
+                   [[maybe_unused]] uint64_t seed = 0, [[maybe_unused]] bool verbose = false,
+                   BuildStats* stats = nullptr) const {
+            Chrono chrono;
+            chrono.start();
             emphf::jenkins64_hasher hasher;
 
             emphf::internal_memory_model mm;
             auto data_iterator = emphf::range(keys.begin(), keys.end());
             emphf_wrapper.m_emphf = emphf::mphf_hem<emphf::jenkins64_hasher>(
                 mm, keys.size(), data_iterator, emphf_wrapper.m_adaptor);
+            chrono.stop();
+            if (stats) stats->add_phase("construction", chrono.elapsed_time());
         }
 
         std::string name() const {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return 1;
+        }
+
+        /**
+         * @return false: EMPHF draws its hash functions from a generator with a fixed seed, so
+         * the structure does not depend on the seed passed to `build`
+         */
+        bool seeded() const {
+            return false;
+        }
+
     private:
         std::string m_name;
     };
 
     template <typename T>
-    inline uint64_t operator()(const T& key) {  // this should be const but `lookup` is not const
+    inline uint64_t operator()(const T& key) const {
         return m_emphf.lookup(key, m_adaptor);
     }
 
@@ -54,6 +76,14 @@ struct EMPHFHEMWrapper {
         return 8 * ss.tellg();
     }
 
+    void save(std::ostream& os) const {
+        m_emphf.save(os);
+    }
+
+    void load(std::istream& is) {
+        m_emphf.load(is);
+    }
+
 private:
     struct Adaptor {
         template <typename T>
@@ -68,10 +98,18 @@ private:
             const uint8_t* end = buf + s.size() + 1;  // add the null terminator
             return emphf::byte_range_t(buf, end);
         }
+
+        // the views have no null terminator, as they point into an arena of keys
+        emphf::byte_range_t operator()(std::string_view s) const {
+            const uint8_t* buf = reinterpret_cast<uint8_t const*>(s.data());
+            return emphf::byte_range_t(buf, buf + s.size());
+        }
     };
 
     Adaptor m_adaptor;
-    emphf::mphf_hem<emphf::jenkins64_hasher> m_emphf;
+    // `lookup` is not declared const, although it only reads the structure and is safe to call
+    // concurrently
+    mutable emphf::mphf_hem<emphf::jenkins64_hasher> m_emphf;
 };
 
 }  // namespace mphf
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #include <fcntl.h>
 #include <sstream>
+#include <string_view>
+
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "utils.hpp"
 
 #include "../external/emphf/base_hash.hpp"
 #include "../external/emphf/hypergraph_sorter_seq.hpp"
@@ -16,16 +21,18 @@ struct EMPHFWrapper {
         }
 
         template <typename T>
-        EMPHFWrapper build(const std::vector<T>& keys, uint64_t seed = 0,
-                           bool verbose = false) const {
+        EMPHFWrapper build(KeySpan<T> keys, uint64_t seed = 0,
+                           bool verbose = false, BuildStats* stats = nullptr) const {
             EMPHFWrapper emphf_wrapper;
-            build(emphf_wrapper, keys, seed, verbose);
+            build(emphf_wrapper, keys, seed, verbose, stats);
             return emphf_wrapper;
         }
 
         template <typename T>
-        void build(EMPHFWrapper& emphf_wrapper, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(EMPHFWrapper& emphf_wrapper, KeySpan<T> keys, [[maybe_unused]] uint64_t seed = 0,
+                   [[maybe_unused]] bool verbose = false, BuildStats* stats = nullptr) const {
+            Chrono chrono;
+            chrono.start();
             size_t max_nodes = (size_t(std::ceil(double(keys.size()) * 1.23)) + 2) / 3 * 3;
             emphf::jenkins64_hasher hasher;
             auto data_iterator = emphf::range(keys.begin(), keys.end());
@@ -39,18 +46,32 @@ struct EMPHFWrapper {
                 emphf_wrapper.m_emphf = emphf::mphf<emphf::jenkins64_hasher>(
                     sorter, keys.size(), data_iterator, emphf_wrapper.m_adaptor);
             }
+            chrono.stop();
+            if (stats) stats->add_phase("construction", chrono.elapsed_time());
         }
 
         std::string name() const {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return 1;
+        }
+
+        /**
+         * @return false: EMPHF draws its hash functions from a generator with a fixed seed, so
+         * the structure does not depend on the seed passed to `build`
+         */
+        bool seeded() const {
+            return false;
+        }
+
     private:
         std::string m_name;
     };
 
     template <typename T>
-    inline uint64_t operator()(const T& key) {  // this should be const but `lookup` is not const
+    inline uint64_t operator()(const T& key) const {
         return m_emphf.lookup(key, m_adaptor);
     }
 
@@ -61,6 +82,14 @@ struct EMPHFWrapper {
         return 8 * ss.tellg();
     }
 
+    void save(std::ostream& os) const {
+        m_emphf.save(os);
+    }
+
+    void load(std::istream& is) {
+        m_emphf.load(is);
+    }
+
 private:
     struct Adaptor {
         template <typename T>
@@ -76,10 +105,18 @@ private:
             const uint8_t* end = buf + s.size() + 1;  // add the null terminator
             return emphf::byte_range_t(buf, end);
         }
+
+        // the views have no null terminator, as they point into an arena of keys
+        emphf::byte_range_t operator()(std::string_view s) const {
+            const uint8_t* buf = reinterpret_cast<uint8_t const*>(s.data());
+            return emphf::byte_range_t(buf, buf + s.size());
+        }
     };
 
     Adaptor m_adaptor;
-    emphf::mphf<emphf::jenkins64_hasher> m_emphf;
+    // `lookup` is not declared const, although it only reads the structure and is safe to call
+    // concurrently
+    mutable emphf::mphf<emphf::jenkins64_hasher> m_emphf;
 };
 
 }  // namespace mphf
\ No newline at end of file
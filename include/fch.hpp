@@ -7,6 +7,9 @@
 #include "fch_utils/buckets.hpp"
 #include "fch_utils/unbalanced_bucketer.hpp"
 #include "fch_utils/compact_container.hpp"
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "serialization.hpp"
 #include "utils.hpp"
 #include "fch_utils/fastmod.h"
 
@@ -44,18 +47,53 @@ struct FCH {
             m_name = ss.str();
         }
 
+        /**
+         * Hashes the keys as the mapping phase of the first fit of `build` with the seed `seed`
+         * does, whatever the parameters of the builder, writing the hash of `keys[i]` to
+         * `hashes[i]`, so that the keys can be hashed ahead of the construction, e.g., while they
+         * are read (see `use_key_hashes`)
+         */
         template <typename T>
-        FCH build(const std::vector<T>& keys, uint64_t seed = 0, bool verbose = false) const {
+        static void hash_keys(KeySpan<T> keys, uint64_t seed, uint64_t* hashes) {
+            const uint64_t bucketer_seed = std::mt19937_64(seed)();
+            Hasher hasher;
+            for (uint64_t i = 0, i_end = keys.size(); i < i_end; ++i) {
+                hashes[i] = hasher(keys[i], bucketer_seed);
+            }
+        }
+
+        /**
+         * Makes the first fit of the builds with the seed `seed` of as many keys as `hashes` map
+         * the keys to buckets from their hashes computed by `hash_keys`, instead of hashing them.
+         * The hashes are not copied, so they must outlive the builds.
+         */
+        Builder& use_key_hashes(KeySpan<uint64_t> hashes, uint64_t seed) {
+            m_key_hashes = hashes;
+            m_key_hashes_seed = seed;
+            return *this;
+        }
+
+        template <typename T>
+        FCH build(KeySpan<T> keys, uint64_t seed = 0, bool verbose = false,
+                  BuildStats* stats = nullptr) const {
             FCH fch;
-            build(fch, keys, seed, verbose);
+            build(fch, keys, seed, verbose, stats);
             return fch;
         }
 
         template <typename T>
-        void build(FCH& fch, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(FCH& fch, KeySpan<T> keys, uint64_t seed = 0,
+                   bool verbose = false, BuildStats* stats = nullptr) const {
             std::mt19937_64 generator(seed);
             Chrono chrono;
+            auto end_phase = [&](const char* phase) {
+                chrono.stop();
+                if (stats) stats->add_phase(phase, chrono.elapsed_time());
+                if (verbose) {
+                    std::cerr << "Time spent in " << phase << " "
+                              << TimeFormatter::format(chrono.elapsed_time(), 1) << std::endl;
+                }
+            };
 
             fch.m_num_keys = keys.size();
             fch.m_num_keys_M = fastmod::computeM_u64(fch.m_num_keys);
@@ -66,30 +104,29 @@ struct FCH {
             for (uint32_t fit_restart = 0; true; ++fit_restart) {
                 try {
                     // mapping
-                    if (verbose) { chrono.reset_and_start(); }
+                    chrono.reset_and_start();
                     fch.m_bucketer.init(keys, num_buckets, generator(), m_perc_keys_first_part,
                                         m_perc_buckets_first_part);
-                    Buckets<T> buckets(keys, fch.m_bucketer);
-                    if (verbose) {
-                        chrono.stop();
-                        std::cerr << "Time spent in mapping "
-                                  << TimeFormatter::format(chrono.elapsed_time(), 1) << std::endl;
-                    }
+                    // the hashes computed ahead are those of the bucketer of the first fit
+                    const bool hashed = fit_restart == 0 && seed == m_key_hashes_seed &&
+                                        !m_key_hashes.empty() &&
+                                        m_key_hashes.size() == keys.size();
+                    Buckets<T> buckets = hashed ? Buckets<T>(keys, m_key_hashes, fch.m_bucketer)
+                                                : Buckets<T>(keys, fch.m_bucketer);
+                    if (hashed && stats) stats->count("prehashed_fits");
+                    end_phase("mapping");
 
                     // ordering
-                    if (verbose) { chrono.reset_and_start(); }
+                    chrono.reset_and_start();
                     std::vector<uint64_t> buckets_order = buckets.get_order_by_size();
-                    if (verbose) {
-                        chrono.stop();
-                        std::cerr << "Time spent in ordering "
-                                  << TimeFormatter::format(chrono.elapsed_time(), 1) << std::endl;
-                    }
+                    end_phase("ordering");
 
                     // searching
-                    if (verbose) { chrono.reset_and_start(); }
+                    chrono.reset_and_start();
                     std::vector<uint64_t> shifts;
                     for (uint32_t search_restart = 0; true; ++search_restart) {
-                        fch.m_seed = get_seed_with_no_inbucket_collisions(buckets, generator);
+                        fch.m_seed = get_seed_with_no_inbucket_collisions(buckets, generator,
+                                                                          stats);
                         try {
                             if (verbose) {
                                 shifts = search<T, true>(buckets, buckets_order, fch.m_seed);
@@ -99,29 +136,23 @@ struct FCH {
                             break;
                         } catch (std::runtime_error& e) {
                             if (search_restart >= m_num_search_restarts) { throw e; }
+                            if (stats) stats->count("search_restarts");
                             if (verbose) {
-                                std::cerr << "fit_restart #" << (fit_restart + 1)
+                                std::cerr << "search_restart #" << (search_restart + 1)
                                           << " caused by: " << e.what() << std::endl;
                             }
                         }
                     }
-                    if (verbose) {
-                        chrono.stop();
-                        std::cerr << "Time spent in searching "
-                                  << TimeFormatter::format(chrono.elapsed_time(), 1) << std::endl;
-                    }
+                    end_phase("searching");
 
                     // encoding
-                    if (verbose) { chrono.reset_and_start(); }
+                    chrono.reset_and_start();
                     fch.m_shifts.init(shifts);
-                    if (verbose) {
-                        chrono.stop();
-                        std::cerr << "Time spent in encoding "
-                                  << TimeFormatter::format(chrono.elapsed_time(), 1) << std::endl;
-                    }
+                    end_phase("encoding");
                     break;
                 } catch (std::runtime_error& e) {
                     if (fit_restart >= m_num_restarts) { throw e; }
+                    if (stats) stats->count("fit_restarts");
                     if (verbose) {
                         std::cerr << "fit_restart #" << (fit_restart + 1)
                                   << " caused by: " << e.what() << std::endl;
@@ -134,13 +165,25 @@ struct FCH {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return 1;
+        }
+
+        /**
+         * @return true if the structure depends on the seed passed to `build`
+         */
+        bool seeded() const {
+            return true;
+        }
+
     private:
         /**
          * Returns a seed that does not cause collisions among the keys of each bucket
          */
         template <typename T>
         uint64_t get_seed_with_no_inbucket_collisions(const Buckets<T>& buckets,
-                                                      std::mt19937_64& generator) const {
+                                                      std::mt19937_64& generator,
+                                                      BuildStats* stats) const {
             Hasher hasher;
             const uint64_t num_keys = buckets.num_keys(), num_buckets = buckets.num_buckets();
             __uint128_t num_keys_M = fastmod::computeM_u64(num_keys);
@@ -176,6 +219,7 @@ struct FCH {
                 }  // end loop over buckets
 
                 if (!collision) { return seed; }
+                if (stats) stats->count("search_reseeds");
             }  // reseed
         }
 
@@ -192,8 +236,8 @@ struct FCH {
 
             // create and fill the random and map tables
             uint64_t filled_count = 0;
-            std::vector<uint64_t> random_table(num_keys);
-            std::vector<uint64_t> map_table(num_keys);
+            huge_page_vector<uint64_t> random_table(num_keys);
+            huge_page_vector<uint64_t> map_table(num_keys);
             for (uint64_t i = 0, i_end = num_keys; i < i_end; ++i) { random_table[i] = i; }
             std::shuffle(random_table.begin(), random_table.end(), std::mt19937_64(seed));
             for (uint64_t i = 0, i_end = num_keys; i < i_end; ++i) {
@@ -294,17 +338,39 @@ struct FCH {
         double m_perc_keys_first_part, m_perc_buckets_first_part;
         uint32_t m_num_restarts, m_num_search_restarts, m_num_search_reseeds;
         std::string m_name;
+        KeySpan<uint64_t> m_key_hashes;  // hashes of the keys computed ahead (empty if none)
+        uint64_t m_key_hashes_seed = 0;
     };  // end Builder
 
     template <typename T>
     inline uint64_t operator()(const T& key) const {
         auto bucket = m_bucketer(key);
-        auto shift = m_shifts[bucket];
+        return position(key, m_shifts[bucket]);
+    }
 
-        // unpack
-        uint64_t seed = m_seed + (shift & 1);
-        shift >>= 1;
-        return fastmod::fastmod_u64(m_hasher(key, seed) + shift, m_num_keys_M, m_num_keys);
+    /**
+     * Looks up the keys in [begin, end), writing their positions to `out`.
+     * Keys are processed in groups of up to `lookup_group_size`: the buckets of all the keys of a
+     * group are computed and their shifts prefetched, before resolving any key of the group, so
+     * that the cache misses of the group overlap with each other.
+     * @param begin A forward iterator, as the keys of a group are visited twice
+     */
+    template <typename Iterator, typename OutputIterator>
+    void lookup_batch(Iterator begin, Iterator end, OutputIterator out) const {
+        uint64_t buckets[lookup_group_size];
+        while (begin != end) {
+            // hash and prefetch
+            uint64_t group_size = 0;
+            for (Iterator it = begin; group_size != lookup_group_size && it != end;
+                 ++group_size, ++it) {
+                buckets[group_size] = m_bucketer(*it);
+                m_shifts.prefetch(buckets[group_size]);
+            }
+            // resolve
+            for (uint64_t i = 0; i != group_size; ++i, ++begin, ++out) {
+                *out = position(*begin, m_shifts[buckets[i]]);
+            }
+        }
     }
 
     inline size_t num_bits() const {
@@ -312,7 +378,45 @@ struct FCH {
                m_shifts.num_bits();
     }
 
+    static constexpr uint64_t lookup_group_size = 64;
+
+    void save(std::ostream& os) const {
+        saver visitor(os);
+        const_cast<FCH*>(this)->visit(visitor);
+    }
+
+    void load(std::istream& is) {
+        loader visitor(is);
+        visit(visitor);
+    }
+
+    /**
+     * Loads the structure saved at [begin, end) without copying its shifts, which are read in place
+     * (the memory must outlive the structure)
+     */
+    void map(const char* begin, const char* end) {
+        mapper visitor(begin, end);
+        visit(visitor);
+    }
+
+    template <typename Visitor>
+    void visit(Visitor& visitor) {
+        visitor.visit(m_num_keys);
+        visitor.visit(m_seed);
+        visitor.visit(m_num_keys_M);
+        visitor.visit(m_bucketer);
+        visitor.visit(m_shifts);
+    }
+
 private:
+    template <typename T>
+    inline uint64_t position(const T& key, uint64_t shift) const {
+        // unpack
+        uint64_t seed = m_seed + (shift & 1);
+        shift >>= 1;
+        return fastmod::fastmod_u64(m_hasher(key, seed) + shift, m_num_keys_M, m_num_keys);
+    }
+
     Hasher m_hasher;
     uint64_t m_num_keys, m_seed;
     __uint128_t m_num_keys_M;
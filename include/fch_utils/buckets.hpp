@@ -5,9 +5,12 @@
 #include <functional>
 #include <vector>
 
+#include "../huge_page_allocator.hpp"
+#include "../key_span.hpp"
+
 template <typename T>
 struct Buckets {
-    typedef typename std::vector<const T*>::const_iterator const_iterator;
+    typedef typename mphf::huge_page_vector<const T*>::const_iterator const_iterator;
 
     Buckets() {
         m_bucket_keys = {};
@@ -16,37 +19,24 @@ struct Buckets {
     }
 
     template <class Bucketer>
-    Buckets(const std::vector<T>& keys, const Bucketer& bucketer) {
-        const uint64_t num_buckets = bucketer.num_buckets();
-
+    Buckets(KeySpan<T> keys, const Bucketer& bucketer) {
         // compute the bucket of each key
         std::vector<uint64_t> buckets(keys.size());
         for (size_t i = 0, i_end = keys.size(); i < i_end; ++i) { buckets[i] = bucketer(keys[i]); }
+        fill(keys, buckets, bucketer.num_buckets());
+    }
 
-        m_bucket_keys.resize(keys.size());
-        m_bucket_offsets.resize(num_buckets + 1);
-
-        // compute the `m_bucket_offsets`
-        // number of keys inside each bucket
-        std::fill(m_bucket_offsets.begin(), m_bucket_offsets.end(), 0);
-        for (size_t i = 0, i_end = keys.size(); i < i_end; ++i) {
-            ++m_bucket_offsets[buckets[i] + 1];
-        }
-        uint64_t biggest_bucket = m_bucket_offsets[0];
-        // cumulative sum of the sizes
-        for (size_t i = 1, i_end = num_buckets + 1; i < i_end; ++i) {
-            if (m_bucket_offsets[i] > biggest_bucket) { biggest_bucket = m_bucket_offsets[i]; }
-            m_bucket_offsets[i] += m_bucket_offsets[i - 1];
-        }
-        m_size_biggest_bucket = biggest_bucket;
-
-        // reorder the (pointer to the) keys within the `m_bucket_keys` vector
-        std::vector<uint64_t> buckets_cursors(num_buckets);
-        std::copy(m_bucket_offsets.begin(), m_bucket_offsets.end() - 1, buckets_cursors.begin());
+    /**
+     * Buckets of the keys whose hashes with the seed of `bucketer` were computed ahead, the one
+     * of `keys[i]` being `hashes[i]`
+     */
+    template <class Bucketer>
+    Buckets(KeySpan<T> keys, KeySpan<uint64_t> hashes, const Bucketer& bucketer) {
+        std::vector<uint64_t> buckets(keys.size());
         for (size_t i = 0, i_end = keys.size(); i < i_end; ++i) {
-            const uint64_t bucket = buckets[i];
-            m_bucket_keys[buckets_cursors[bucket]++] = &keys[i];
+            buckets[i] = bucketer.bucket(hashes[i]);
         }
+        fill(keys, buckets, bucketer.num_buckets());
     }
 
     std::vector<uint64_t> get_order_by_size() const {
@@ -115,7 +105,37 @@ struct Buckets {
     }
 
 private:
-    std::vector<const T*> m_bucket_keys;
-    std::vector<uint64_t> m_bucket_offsets;
+    /**
+     * Sorts the keys by bucket, the one of `keys[i]` being `buckets[i]`
+     */
+    void fill(KeySpan<T> keys, std::vector<uint64_t> const& buckets, uint64_t num_buckets) {
+        m_bucket_keys.resize(keys.size());
+        m_bucket_offsets.resize(num_buckets + 1);
+
+        // compute the `m_bucket_offsets`
+        // number of keys inside each bucket
+        std::fill(m_bucket_offsets.begin(), m_bucket_offsets.end(), 0);
+        for (size_t i = 0, i_end = keys.size(); i < i_end; ++i) {
+            ++m_bucket_offsets[buckets[i] + 1];
+        }
+        uint64_t biggest_bucket = m_bucket_offsets[0];
+        // cumulative sum of the sizes
+        for (size_t i = 1, i_end = num_buckets + 1; i < i_end; ++i) {
+            if (m_bucket_offsets[i] > biggest_bucket) { biggest_bucket = m_bucket_offsets[i]; }
+            m_bucket_offsets[i] += m_bucket_offsets[i - 1];
+        }
+        m_size_biggest_bucket = biggest_bucket;
+
+        // reorder the (pointer to the) keys within the `m_bucket_keys` vector
+        std::vector<uint64_t> buckets_cursors(num_buckets);
+        std::copy(m_bucket_offsets.begin(), m_bucket_offsets.end() - 1, buckets_cursors.begin());
+        for (size_t i = 0, i_end = keys.size(); i < i_end; ++i) {
+            const uint64_t bucket = buckets[i];
+            m_bucket_keys[buckets_cursors[bucket]++] = &keys[i];
+        }
+    }
+
+    mphf::huge_page_vector<const T*> m_bucket_keys;
+    mphf::huge_page_vector<uint64_t> m_bucket_offsets;
     uint64_t m_size_biggest_bucket;
 };
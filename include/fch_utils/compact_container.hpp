@@ -24,10 +24,20 @@ struct compact_container {
         return m_values.access(i);
     }
 
+    inline void prefetch(uint64_t i) const {
+        assert(i < m_values.size());
+        m_values.prefetch(i);
+    }
+
     static std::string name() {
         return "Compact";
     }
 
+    template <typename Visitor>
+    void visit(Visitor& visitor) {
+        visitor.visit(m_values);
+    }
+
 private:
     compact_vector m_values;
 };
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <vector>
 #include <cmath>
 
+#include "../huge_page_allocator.hpp"
+
 struct compact_vector {
     template <typename Data>
     struct enumerator {
@@ -51,11 +53,11 @@ struct compact_vector {
 
         void read() {
             if (m_cur_shift + m_data->m_width <= 64) {
-                m_cur_val = m_data->m_bits[m_cur_block] >> m_cur_shift & m_data->m_mask;
+                m_cur_val = m_data->words()[m_cur_block] >> m_cur_shift & m_data->m_mask;
             } else {
                 uint64_t res_shift = 64 - m_cur_shift;
-                m_cur_val = (m_data->m_bits[m_cur_block] >> m_cur_shift) |
-                            (m_data->m_bits[m_cur_block + 1] << res_shift & m_data->m_mask);
+                m_cur_val = (m_data->words()[m_cur_block] >> m_cur_shift) |
+                            (m_data->words()[m_cur_block + 1] << res_shift & m_data->m_mask);
                 ++m_cur_block;
                 m_cur_shift = -res_shift;
             }
@@ -164,6 +166,7 @@ struct compact_vector {
             cv.m_width = m_width;
             cv.m_mask = m_mask;
             cv.m_bits.swap(m_bits);
+            cv.m_words = cv.m_bits.data();
             builder().swap(*this);
         }
 
@@ -188,10 +191,14 @@ struct compact_vector {
             return m_width;
         }
 
-        std::vector<uint64_t>& bits() {
+        mphf::huge_page_vector<uint64_t>& bits() {
             return m_bits;
         }
 
+        inline uint64_t const* words() const {
+            return m_bits.data();
+        }
+
     private:
         uint64_t m_size;
         uint64_t m_width;
@@ -199,10 +206,26 @@ struct compact_vector {
         uint64_t m_back;
         uint64_t m_cur_block;
         int64_t m_cur_shift;
-        std::vector<uint64_t> m_bits;
+        mphf::huge_page_vector<uint64_t> m_bits;
     };
 
-    compact_vector() : m_size(0), m_width(0), m_mask(0) {}
+    compact_vector() : m_size(0), m_width(0), m_mask(0), m_words(nullptr) {}
+
+    // a copy of a mapped vector shares the mapped words
+    compact_vector(compact_vector const& other)
+        : m_size(other.m_size)
+        , m_width(other.m_width)
+        , m_mask(other.m_mask)
+        , m_bits(other.m_bits)
+        , m_words(other.m_bits.empty() ? other.m_words : m_bits.data()) {}
+
+    compact_vector& operator=(compact_vector const& other) {
+        compact_vector(other).swap(*this);
+        return *this;
+    }
+
+    compact_vector(compact_vector&&) = default;
+    compact_vector& operator=(compact_vector&&) = default;
 
     template <typename Iterator>
     void build(Iterator begin, uint64_t n) {
@@ -224,18 +247,25 @@ struct compact_vector {
         uint64_t block = pos >> 6;
         uint64_t shift = pos & 63;
         return shift + m_width <= 64
-                   ? m_bits[block] >> shift & m_mask
-                   : (m_bits[block] >> shift) | (m_bits[block + 1] << (64 - shift) & m_mask);
+                   ? m_words[block] >> shift & m_mask
+                   : (m_words[block] >> shift) | (m_words[block + 1] << (64 - shift) & m_mask);
     }
 
     // it retrieves at least 57 bits
     inline uint64_t access(uint64_t pos) const {
         assert(pos < size());
         uint64_t i = pos * m_width;
-        const char* ptr = reinterpret_cast<const char*>(m_bits.data());
+        const char* ptr = reinterpret_cast<const char*>(m_words);
         return (*(reinterpret_cast<uint64_t const*>(ptr + (i >> 3))) >> (i & 7)) & m_mask;
     }
 
+    // it brings into the cache the word read by `access(pos)`
+    inline void prefetch(uint64_t pos) const {
+        uint64_t i = pos * m_width;
+        const char* ptr = reinterpret_cast<const char*>(m_words);
+        __builtin_prefetch(ptr + (i >> 3));
+    }
+
     uint64_t back() const {
         return operator[](size() - 1);
     }
@@ -262,12 +292,13 @@ struct compact_vector {
         return iterator(this, pos);
     }
 
-    std::vector<uint64_t> const& bits() const {
-        return m_bits;
+    inline uint64_t const* words() const {
+        return m_words;
     }
 
     size_t bytes() const {
-        return sizeof(m_size) + sizeof(m_width) + sizeof(m_mask) + vec_bytes(m_bits);
+        return sizeof(m_size) + sizeof(m_width) + sizeof(m_mask) + sizeof(uint64_t) +
+               num_words() * sizeof(uint64_t);
     }
 
     void swap(compact_vector& other) {
@@ -275,20 +306,24 @@ struct compact_vector {
         std::swap(m_width, other.m_width);
         std::swap(m_mask, other.m_mask);
         m_bits.swap(other.m_bits);
+        std::swap(m_words, other.m_words);
     }
 
+    /**
+     * The words are either owned by the vector or, after a visit by `mphf::mapper`, viewed in
+     * place in the mapped memory
+     */
     template <typename Visitor>
     void visit(Visitor& visitor) {
         visitor.visit(m_size);
         visitor.visit(m_width);
         visitor.visit(m_mask);
-        visitor.visit(m_bits);
+        visitor.visit_array(m_bits, m_words, num_words());
     }
 
 private:
-    template <typename T>
-    static size_t vec_bytes(T const& vec) {
-        return vec.size() * sizeof(vec.front()) + sizeof(typename T::size_type);
+    inline uint64_t num_words() const {
+        return words_for(m_size * m_width);
     }
 
     template <typename WordType = uint64_t>
@@ -300,5 +335,6 @@ private:
     uint64_t m_size;
     uint64_t m_width;
     uint64_t m_mask;
-    std::vector<uint64_t> m_bits;
+    mphf::huge_page_vector<uint64_t> m_bits;
+    uint64_t const* m_words;  // the words of `m_bits`, or of a memory mapping
 };
@@ -4,11 +4,12 @@
 #include <stdexcept>
 
 #include "fastmod.h"
+#include "../key_span.hpp"
 
 template <typename Hasher>
 struct unbalanced_bucketer {
     template <typename T>
-    void init(const std::vector<T>& keys, uint64_t num_buckets, uint64_t seed = 0,
+    void init(KeySpan<T> keys, uint64_t num_buckets, uint64_t seed = 0,
               double perc_keys_first_part = 0.6, double perc_buckets_first_part = 0.3) {
         if (num_buckets == 0 || num_buckets > keys.size()) {
             throw std::invalid_argument(
@@ -36,7 +37,13 @@ struct unbalanced_bucketer {
 
     template <typename T>
     inline uint64_t operator()(T const& key) const {
-        auto hash = m_hasher(key, m_seed);
+        return bucket(m_hasher(key, m_seed));
+    }
+
+    /**
+     * @return The bucket of a key whose hash, with the seed of the bucketer, is `hash`
+     */
+    inline uint64_t bucket(uint64_t hash) const {
         auto b =
             (hash < m_hash_threshold)
                 ? fastmod::fastmod_u64(hash, m_buckets_first_part_M,
@@ -55,6 +62,17 @@ struct unbalanced_bucketer {
                     sizeof(m_buckets_first_part) + sizeof(m_buckets_second_part));
     }
 
+    template <typename Visitor>
+    void visit(Visitor& visitor) {
+        visitor.visit(m_num_buckets);
+        visitor.visit(m_seed);
+        visitor.visit(m_hash_threshold);
+        visitor.visit(m_buckets_first_part);
+        visitor.visit(m_buckets_second_part);
+        visitor.visit(m_buckets_first_part_M);
+        visitor.visit(m_buckets_second_part_M);
+    }
+
 private:
     Hasher m_hasher;
     uint64_t m_num_buckets, m_seed;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <string_view>
+
 #include "../base_hasher/murmur2_base_hasher.hpp"
 
 namespace mphf::hasher {
@@ -15,6 +18,10 @@ struct Hasher {
         return m_base_hasher(key.data(), key.length(), seed);
     };
 
+    inline uint64_t operator()(std::string_view key, uint64_t seed = 0) const {
+        return m_base_hasher(key.data(), key.length(), seed);
+    };
+
 private:
     BaseHasher m_base_hasher;
 };
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace mphf {
+
+/**
+ * Pages backing the large arrays allocated by `huge_page_allocator`
+ */
+enum class PageMode {
+    SMALL,        // `4k`: the default pages, from the global allocator
+    TRANSPARENT,  // `thp`: 2 MiB aligned memory advised to use transparent huge pages
+    HUGE_2M       // `2m`: explicit 2 MiB huge pages (MAP_HUGETLB), from the reserved pool
+};
+
+inline PageMode parse_page_mode(std::string const& name) {
+    if (name == "4k") return PageMode::SMALL;
+    if (name == "thp") return PageMode::TRANSPARENT;
+    if (name == "2m") return PageMode::HUGE_2M;
+    throw std::invalid_argument("Unknown page mode `" + name +
+                                "`, expected one of `4k`, `thp`, `2m`");
+}
+
+inline const char* page_mode_name(PageMode mode) {
+    switch (mode) {
+        case PageMode::SMALL:
+            return "4k";
+        case PageMode::TRANSPARENT:
+            return "thp";
+        case PageMode::HUGE_2M:
+            return "2m";
+    }
+    return "";
+}
+
+namespace detail {
+
+inline std::atomic<PageMode>& default_page_mode() {
+    static std::atomic<PageMode> mode(PageMode::SMALL);
+    return mode;
+}
+
+inline std::atomic<uint64_t>& huge_page_fallbacks() {
+    static std::atomic<uint64_t> fallbacks(0);
+    return fallbacks;
+}
+
+}  // namespace detail
+
+/**
+ * @return The page mode of the allocators created from now on
+ */
+inline PageMode default_page_mode() {
+    return detail::default_page_mode().load();
+}
+
+inline void set_default_page_mode(PageMode mode) {
+    detail::default_page_mode() = mode;
+}
+
+/**
+ * @return The number of allocations in `2m` mode that fell back to transparent huge pages, since
+ * no explicit huge page was available (see /proc/sys/vm/nr_hugepages)
+ */
+inline uint64_t huge_page_fallbacks() {
+    return detail::huge_page_fallbacks().load();
+}
+
+/**
+ * @return The number of free explicit 2 MiB huge pages, reserved in /proc/sys/vm/nr_hugepages
+ */
+inline uint64_t free_huge_pages() {
+    std::ifstream file("/sys/kernel/mm/hugepages/hugepages-2048kB/free_hugepages");
+    uint64_t pages = 0;
+    if (!(file >> pages)) return 0;
+    return pages;
+}
+
+/**
+ * Sets the default page mode from its construction until its destruction
+ */
+class scoped_page_mode {
+public:
+    scoped_page_mode(PageMode mode) : m_previous(default_page_mode()) {
+        set_default_page_mode(mode);
+    }
+
+    scoped_page_mode(scoped_page_mode const&) = delete;
+    scoped_page_mode& operator=(scoped_page_mode const&) = delete;
+
+    ~scoped_page_mode() {
+        set_default_page_mode(m_previous);
+    }
+
+private:
+    PageMode m_previous;
+};
+
+/**
+ * Allocator backing the arrays of at least 2 MiB with the pages of its mode, which is the default
+ * page mode at its construction. Smaller arrays, and all the arrays in `4k` mode, come from the
+ * global `operator new`. The mode follows the containers on copy, move and swap.
+ */
+template <typename T>
+class huge_page_allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    static constexpr size_t huge_page_bytes = size_t(1) << 21;
+
+    huge_page_allocator() : m_mode(default_page_mode()) {}
+
+    template <typename U>
+    huge_page_allocator(huge_page_allocator<U> const& other) : m_mode(other.mode()) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (!is_mapped(bytes)) return static_cast<T*>(::operator new(bytes));
+#ifdef __linux__
+        size_t length = mapped_length(bytes);
+        if (m_mode == PageMode::HUGE_2M) {
+            void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) return static_cast<T*>(ptr);
+            ++detail::huge_page_fallbacks();
+        }
+        // over-allocate by one huge page, so as to trim the mapping to a 2 MiB aligned one
+        char* ptr = static_cast<char*>(mmap(nullptr, length + huge_page_bytes,
+                                            PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (ptr == MAP_FAILED) throw std::bad_alloc();
+        size_t head = (huge_page_bytes - reinterpret_cast<uintptr_t>(ptr) % huge_page_bytes) %
+                      huge_page_bytes;
+        if (head != 0) munmap(ptr, head);
+        munmap(ptr + head + length, huge_page_bytes - head);
+        madvise(ptr + head, length, MADV_HUGEPAGE);
+        return reinterpret_cast<T*>(ptr + head);
+#else
+        return static_cast<T*>(::operator new(bytes));
+#endif
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        size_t bytes = n * sizeof(T);
+#ifdef __linux__
+        if (is_mapped(bytes)) {
+            munmap(ptr, mapped_length(bytes));
+            return;
+        }
+#endif
+        ::operator delete(ptr);
+    }
+
+    inline PageMode mode() const {
+        return m_mode;
+    }
+
+    template <typename U>
+    bool operator==(huge_page_allocator<U> const& other) const {
+        return m_mode == other.mode();
+    }
+
+    template <typename U>
+    bool operator!=(huge_page_allocator<U> const& other) const {
+        return m_mode != other.mode();
+    }
+
+private:
+    inline bool is_mapped(size_t bytes) const {
+        return m_mode != PageMode::SMALL && bytes >= huge_page_bytes;
+    }
+
+    static size_t mapped_length(size_t bytes) {
+        return (bytes + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+    }
+
+    PageMode m_mode;
+};
+
+/**
+ * A vector backed by `huge_page_allocator`
+ */
+template <typename T>
+using huge_page_vector = std::vector<T, huge_page_allocator<T>>;
+
+}  // namespace mphf
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "serialization.hpp"
+
+/**
+ * Calls `on_block(block, mask)` for the blocks of 64 bytes of [begin, end) (the last one may be
+ * shorter), where the i-th bit of `mask` tells whether `block[i]` is `delimiter`. The bytes are
+ * compared 32 (AVX2) or 16 (SSE2) at a time.
+ */
+template <typename Function>
+void scan_delimiters(const char* begin, const char* end, char delimiter, Function on_block) {
+    const char* block = begin;
+#if defined(__AVX2__)
+    const __m256i pattern = _mm256_set1_epi8(delimiter);
+    for (; end - block >= 64; block += 64) {
+        auto compare = [&](const char* p) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            return uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, pattern))));
+        };
+        on_block(block, compare(block) | compare(block + 32) << 32);
+    }
+#elif defined(__SSE2__)
+    const __m128i pattern = _mm_set1_epi8(delimiter);
+    for (; end - block >= 64; block += 64) {
+        uint64_t mask = 0;
+        for (int i = 0; i != 4; ++i) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+            mask |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, pattern))))
+                    << (16 * i);
+        }
+        on_block(block, mask);
+    }
+#endif
+    for (; block < end; block += 64) {
+        uint64_t mask = 0;
+        for (int i = 0; i != 64 && block + i != end; ++i) {
+            mask |= uint64_t(block[i] == delimiter) << i;
+        }
+        on_block(block, mask);
+    }
+}
+
+/**
+ * Contiguous storage of string keys, which are viewed in place by `std::string_view`s instead of
+ * being copied into a `std::string` each: the keys take their bytes plus one view per key, and no
+ * allocation per key. The bytes are either a read-only memory mapping of a file, so that they are
+ * loaded at disk bandwidth and can be dropped by the kernel under memory pressure, or a single
+ * buffer filled from a stream that cannot be mapped (e.g., the standard input).
+ */
+class KeyArena {
+public:
+    /**
+     * Maps the file `filename`, which must not be modified while the arena exists
+     */
+    explicit KeyArena(std::string const& filename)
+        : m_file(std::make_unique<mphf::mapped_file>(filename)) {
+        m_begin = m_file->data();
+        m_end = m_begin + m_file->size();
+        // the keys are scanned right away, so start reading the file ahead
+        madvise(const_cast<char*>(m_begin), m_file->size(), MADV_WILLNEED);
+    }
+
+    /**
+     * Reads all of `is` into the arena
+     */
+    explicit KeyArena(std::istream& is) {
+        const uint64_t chunk_size = 1 << 24;
+        uint64_t size = 0;
+        while (is) {
+            m_buffer.resize(size + chunk_size);
+            is.read(m_buffer.data() + size, chunk_size);
+            size += is.gcount();
+        }
+        m_buffer.resize(size);
+        m_begin = m_buffer.data();
+        m_end = m_begin + size;
+    }
+
+    // the views of the keys point into the arena, which is therefore neither copied nor moved
+    KeyArena(KeyArena const&) = delete;
+    KeyArena& operator=(KeyArena const&) = delete;
+
+    /**
+     * @return Views of the first `num_keys` keys (or of all of them, if 0), separated by
+     * `delimiter` like the lines read by `std::getline`: a delimiter at the end of the arena does
+     * not start an empty key.
+     *
+     * The arena is cut into `num_threads` chunks, each one ending with a delimiter, which are
+     * scanned concurrently twice: first to count their keys, so that the views are allocated once
+     * and each chunk knows where its views start, then to write the views.
+     */
+    std::vector<std::string_view> split(char delimiter = '\n', uint64_t num_keys = 0,
+                                        unsigned num_threads = 1) const {
+        num_threads = std::max(1u, num_threads);
+        const uint64_t size = m_end - m_begin;
+        std::vector<const char*> bounds{m_begin};
+        for (unsigned i = 1; i != num_threads; ++i) {
+            // the chunk starts with the first key starting at or after its nominal start
+            const char* nominal = m_begin + size * i / num_threads;
+            const char* begin = std::max(bounds.back(), nominal == m_begin ? nominal : nominal - 1);
+            auto delimiter_pos = static_cast<const char*>(memchr(begin, delimiter, m_end - begin));
+            bounds.push_back(delimiter_pos ? delimiter_pos + 1 : m_end);
+        }
+        bounds.push_back(m_end);
+
+        auto in_parallel = [&](auto chunk_function) {
+            std::vector<std::thread> threads;
+            for (unsigned i = 1; i != num_threads; ++i) threads.emplace_back(chunk_function, i);
+            chunk_function(0);
+            for (auto& thread : threads) thread.join();
+        };
+
+        std::vector<uint64_t> first_key(num_threads + 1, 0);
+        in_parallel([&](unsigned i) {
+            uint64_t count = 0;
+            auto count_keys = [&](const char*, uint64_t mask) {
+                count += __builtin_popcountll(mask);
+            };
+            scan_delimiters(bounds[i], bounds[i + 1], delimiter, count_keys);
+            // only the last chunk can end without a delimiter
+            if (bounds[i] != bounds[i + 1] && bounds[i + 1][-1] != delimiter) ++count;
+            first_key[i + 1] = count;
+        });
+        for (unsigned i = 0; i != num_threads; ++i) first_key[i + 1] += first_key[i];
+
+        uint64_t count = first_key.back();
+        if (num_keys != 0) count = std::min(count, num_keys);
+        std::vector<std::string_view> keys(count);
+        in_parallel([&](unsigned i) {
+            uint64_t k = first_key[i];
+            if (k >= count) return;
+            const char* key_begin = bounds[i];
+            auto write_views = [&](const char* block, uint64_t mask) {
+                for (; mask != 0 && k != count; mask &= mask - 1) {
+                    const char* key_end = block + __builtin_ctzll(mask);
+                    keys[k++] = std::string_view(key_begin, key_end - key_begin);
+                    key_begin = key_end + 1;
+                }
+            };
+            scan_delimiters(bounds[i], bounds[i + 1], delimiter, write_views);
+            if (k != count && key_begin != bounds[i + 1]) {
+                keys[k] = std::string_view(key_begin, bounds[i + 1] - key_begin);
+            }
+        });
+        return keys;
+    }
+
+    /**
+     * @return The number of bytes of the arena
+     */
+    inline uint64_t size() const {
+        return m_end - m_begin;
+    }
+
+    inline bool mapped() const {
+        return m_file != nullptr;
+    }
+
+private:
+    std::unique_ptr<mphf::mapped_file> m_file;
+    std::vector<char> m_buffer;
+    const char* m_begin;
+    const char* m_end;
+};
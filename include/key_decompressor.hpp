@@ -0,0 +1,276 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+#ifdef MPHF_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef MPHF_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "key_pipeline.hpp"
+#include "serialization.hpp"
+
+enum class Compression {
+    NONE,
+    GZIP,  // `gzip`: one or more gzip members (also zlib streams)
+    ZSTD   // `zstd`: one or more zstd frames
+};
+
+inline const char* compression_name(Compression compression) {
+    switch (compression) {
+        case Compression::NONE:
+            return "none";
+        case Compression::GZIP:
+            return "gzip";
+        case Compression::ZSTD:
+            return "zstd";
+    }
+    return "";
+}
+
+/**
+ * @return The compression of the `size` bytes of `data`, recognized by their magic number
+ */
+inline Compression detect_compression(const char* data, uint64_t size) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) return Compression::GZIP;
+    if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+/**
+ * @return The compression of the file `filename`, recognized by its magic number
+ */
+inline Compression detect_file_compression(std::string const& filename) {
+    std::ifstream is(filename, std::ios::binary);
+    if (!is) throw std::runtime_error("Unable to open `" + filename + "`");
+    char magic[4];
+    is.read(magic, sizeof(magic));
+    return detect_compression(magic, is.gcount());
+}
+
+/**
+ * Stream buffer of the decompressed bytes of a memory-mapped gzip or zstd file, which are produced
+ * by a dedicated thread and passed through a queue of `queue_capacity` chunks of `chunk_size`
+ * bytes, so that the decompression runs concurrently with the parsing of the previous chunks (e.g.,
+ * by a `PipelinedKeyReader` reading an `std::istream` on this buffer). The queue bounds the memory
+ * of the chunks decompressed ahead of the parsing.
+ */
+class DecompressingStreambuf : public std::streambuf {
+public:
+    struct Stats {
+        uint64_t compressed_bytes = 0;
+        uint64_t bytes = 0;  // decompressed
+        double seconds = 0;  // time spent decompressing, excluding the waits on the full queue
+    };
+
+    DecompressingStreambuf(std::string const& filename, uint64_t chunk_size = uint64_t(1) << 22,
+                           uint64_t queue_capacity = 8)
+        : m_file(std::make_unique<mphf::mapped_file>(filename))
+        , m_compression(detect_compression(m_file->data(), m_file->size()))
+        , m_chunk_size(std::max<uint64_t>(chunk_size, 1))
+        , m_queue(queue_capacity) {
+        if (m_compression == Compression::NONE) {
+            throw std::runtime_error("`" + filename +
+                                     "` is compressed neither by gzip nor by zstd");
+        }
+#ifndef MPHF_HAVE_ZLIB
+        if (m_compression == Compression::GZIP) {
+            throw std::runtime_error("Unable to read `" + filename + "`: built without zlib");
+        }
+#endif
+#ifndef MPHF_HAVE_ZSTD
+        if (m_compression == Compression::ZSTD) {
+            throw std::runtime_error("Unable to read `" + filename + "`: built without zstd");
+        }
+#endif
+        // the file is read sequentially, once
+        madvise(const_cast<char*>(m_file->data()), m_file->size(), MADV_SEQUENTIAL);
+        m_thread = std::thread([this] { decompress(); });
+    }
+
+    DecompressingStreambuf(DecompressingStreambuf const&) = delete;
+    DecompressingStreambuf& operator=(DecompressingStreambuf const&) = delete;
+
+    ~DecompressingStreambuf() {
+        // unblock the thread if the reading stopped before the end of the file
+        if (m_thread.joinable()) {
+            m_stop = true;
+            while (m_queue.pop()) {}
+            m_thread.join();
+        }
+    }
+
+    inline Compression compression() const {
+        return m_compression;
+    }
+
+    /**
+     * Waits for the end of the decompression, which is stopped if the stream has not been read
+     * to its end
+     * @return The statistics of the decompression
+     * @throws std::runtime_error if the file is corrupted or the decompression failed (e.g., out of
+     * memory)
+     */
+    Stats const& finish() {
+        if (m_thread.joinable()) {
+            m_stop = true;
+            while (m_queue.pop()) {}
+            m_thread.join();
+        }
+        if (!m_error.empty()) throw std::runtime_error(m_error);
+        return m_stats;
+    }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        std::optional<std::vector<char>> chunk = m_queue.pop();
+        if (!chunk) return traits_type::eof();
+        m_chunk = std::move(*chunk);
+        setg(m_chunk.data(), m_chunk.data(), m_chunk.data() + m_chunk.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    void decompress() {
+        try {
+            if (m_compression == Compression::GZIP) {
+                decompress_gzip();
+            } else {
+                decompress_zstd();
+            }
+        } catch (std::exception const& e) {
+            m_error = e.what();
+        } catch (...) {
+            m_error = "Unknown error while decompressing";
+        }
+        // always close the queue, so that the reader does not wait for chunks that never come
+        m_queue.close();
+    }
+
+    /**
+     * Passes the chunk to the reader, not counting the time waiting for room in the queue
+     * @return false if the reader stopped
+     */
+    bool push(std::vector<char>& chunk, clock::time_point& start) {
+        m_stats.bytes += chunk.size();
+        m_stats.seconds += std::chrono::duration<double>(clock::now() - start).count();
+        if (m_stop) return false;
+        m_queue.push(std::move(chunk));
+        chunk = std::vector<char>(m_chunk_size);
+        start = clock::now();
+        return true;
+    }
+
+    void decompress_gzip() {
+#ifdef MPHF_HAVE_ZLIB
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        // 15 + 32: the largest window, with automatic detection of the gzip and zlib headers
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::runtime_error("Unable to initialize zlib");
+        }
+        const char* input = m_file->data();
+        const char* input_end = input + m_file->size();
+        std::vector<char> chunk(m_chunk_size);
+        uint64_t chunk_used = 0;
+        auto start = clock::now();
+        int ret = Z_OK;
+        while (true) {
+            // zlib counts the bytes with 32-bit integers
+            const uint64_t input_size = std::min<uint64_t>(input_end - input, UINT32_MAX);
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+            stream.avail_in = input_size;
+            stream.next_out = reinterpret_cast<Bytef*>(chunk.data() + chunk_used);
+            stream.avail_out = std::min<uint64_t>(chunk.size() - chunk_used, UINT32_MAX);
+            const uint64_t avail_out = stream.avail_out;
+            ret = inflate(&stream, Z_NO_FLUSH);
+            input += input_size - stream.avail_in;
+            chunk_used += avail_out - stream.avail_out;
+            if (ret == Z_STREAM_END) {
+                if (input == input_end) break;
+                inflateReset(&stream);  // a gzip file can be made of several members
+            } else if (ret != Z_OK && !(ret == Z_BUF_ERROR && stream.avail_out == 0)) {
+                break;
+            } else if (input == input_end && stream.avail_out != 0) {
+                ret = Z_DATA_ERROR;  // truncated
+                break;
+            }
+            if (chunk_used == chunk.size()) {
+                if (!push(chunk, start)) break;
+                chunk_used = 0;
+            }
+        }
+        inflateEnd(&stream);
+        m_stats.compressed_bytes = input - m_file->data();
+        if (ret != Z_STREAM_END && !m_stop) {
+            throw std::runtime_error("The gzip data is corrupted or truncated");
+        }
+        chunk.resize(chunk_used);
+        if (chunk_used != 0) push(chunk, start);
+#endif
+    }
+
+    void decompress_zstd() {
+#ifdef MPHF_HAVE_ZSTD
+        std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> stream(ZSTD_createDStream(),
+                                                                        ZSTD_freeDStream);
+        if (!stream) throw std::runtime_error("Unable to initialize zstd");
+        ZSTD_inBuffer input = {m_file->data(), m_file->size(), 0};
+        std::vector<char> chunk(m_chunk_size);
+        ZSTD_outBuffer output = {chunk.data(), chunk.size(), 0};
+        auto start = clock::now();
+        size_t ret = 0;
+        while (true) {
+            ret = ZSTD_decompressStream(stream.get(), &output, &input);
+            if (ZSTD_isError(ret)) {
+                throw std::runtime_error(std::string("The zstd data is corrupted: ") +
+                                         ZSTD_getErrorName(ret));
+            }
+            // a full chunk may leave decompressed bytes in the stream, even at the end of the input
+            const bool full = output.pos == output.size;
+            if (full) {
+                if (!push(chunk, start)) break;
+                output = {chunk.data(), chunk.size(), 0};
+            }
+            if (input.pos == input.size && !full) break;
+        }
+        m_stats.compressed_bytes = input.pos;
+        if (m_stop) return;
+        // a non-zero hint at the end of the input means that the last frame is incomplete
+        if (ret != 0) throw std::runtime_error("The zstd data is truncated");
+        chunk.resize(output.pos);
+        if (output.pos != 0) push(chunk, start);
+#endif
+    }
+
+    std::unique_ptr<mphf::mapped_file> m_file;
+    const Compression m_compression;
+    const uint64_t m_chunk_size;
+    BoundedQueue<std::vector<char>> m_queue;
+    std::vector<char> m_chunk;  // the chunk being read
+    std::atomic<bool> m_stop{false};
+    std::string m_error;
+    Stats m_stats;
+    std::thread m_thread;  // last, so that it starts after the other members are initialized
+};
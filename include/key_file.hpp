@@ -0,0 +1,272 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "key_span.hpp"
+#include "serialization.hpp"
+
+/**
+ * Formats of the files of keys. The integer keys are raw arrays of little-endian integers of 4, 8
+ * or 16 bytes with no header, such as the dumps of a column of IDs, so that `n` keys take exactly
+ * `n` times their size. The string keys are stored as:
+ *
+ *   - the 8 bytes of `string_key_file_magic`;
+ *   - the number `n` of keys, a little-endian uint64;
+ *   - the index: the offsets of the `n` records from the first one, little-endian uint64s;
+ *   - the `n` records: the length of a key, a little-endian uint32, followed by its bytes.
+ */
+enum class KeyFileFormat {
+    TEXT,    // `text`: one key per line
+    U32,     // `u32`: uint32 keys
+    U64,     // `u64`: uint64 keys
+    U128,    // `u128`: 128-bit unsigned keys
+    STRINGS  // `strings`: length-prefixed string keys with an index
+};
+
+constexpr char string_key_file_magic[8] = {'M', 'P', 'H', 'F', 'K', 'E', 'Y', 'S'};
+
+inline KeyFileFormat parse_key_file_format(std::string const& name) {
+    if (name == "text") return KeyFileFormat::TEXT;
+    if (name == "u32") return KeyFileFormat::U32;
+    if (name == "u64") return KeyFileFormat::U64;
+    if (name == "u128") return KeyFileFormat::U128;
+    if (name == "strings") return KeyFileFormat::STRINGS;
+    throw std::invalid_argument("Unknown key file format `" + name +
+                                "`, expected one of `text`, `u32`, `u64`, `u128`, `strings`");
+}
+
+inline const char* key_file_format_name(KeyFileFormat format) {
+    switch (format) {
+        case KeyFileFormat::TEXT:
+            return "text";
+        case KeyFileFormat::U32:
+            return "u32";
+        case KeyFileFormat::U64:
+            return "u64";
+        case KeyFileFormat::U128:
+            return "u128";
+        case KeyFileFormat::STRINGS:
+            return "strings";
+    }
+    return "";
+}
+
+/**
+ * @return The size in bytes of an integer key of `format`, or 0 if its keys are not integers
+ */
+inline uint64_t key_file_integer_bytes(KeyFileFormat format) {
+    switch (format) {
+        case KeyFileFormat::U32:
+            return 4;
+        case KeyFileFormat::U64:
+            return 8;
+        case KeyFileFormat::U128:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+template <typename T>
+inline T load_little_endian(const char* bytes) {
+    T value;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    char reversed[sizeof(T)];
+    std::reverse_copy(bytes, bytes + sizeof(T), reversed);
+    std::memcpy(&value, reversed, sizeof(T));
+#else
+    std::memcpy(&value, bytes, sizeof(T));
+#endif
+    return value;
+}
+
+template <typename T>
+inline void store_little_endian(std::ostream& os, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    os.write(bytes, sizeof(T));
+}
+
+/**
+ * @return The unsigned decimal integer `text`, which must fit in `T` (e.g., a line of a file of
+ * integer keys in the `text` format)
+ */
+template <typename T>
+T parse_integer_key(std::string_view text) {
+    if (text.empty()) throw std::invalid_argument("Empty integer key");
+    T value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            throw std::invalid_argument("Malformed integer key `" + std::string(text) + "`");
+        }
+        T digit = c - '0';
+        if (value > (T(~T(0)) - digit) / 10) {
+            throw std::invalid_argument("The key `" + std::string(text) + "` exceeds " +
+                                        std::to_string(8 * sizeof(T)) + " bits");
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+/**
+ * Writes the file of string keys [begin, end) in the `strings` format
+ * @throws std::invalid_argument if a key is too long for the format, before anything is written
+ */
+template <typename Iterator>
+void write_string_key_file(std::ostream& os, Iterator begin, Iterator end) {
+    for (Iterator it = begin; it != end; ++it) {
+        if (it->size() > UINT32_MAX) {
+            throw std::invalid_argument(
+                "The keys of the `strings` format must be shorter than 4 GiB");
+        }
+    }
+    os.write(string_key_file_magic, sizeof(string_key_file_magic));
+    store_little_endian<uint64_t>(os, std::distance(begin, end));
+    uint64_t offset = 0;
+    for (Iterator it = begin; it != end; ++it) {
+        store_little_endian<uint64_t>(os, offset);
+        offset += sizeof(uint32_t) + it->size();
+    }
+    for (Iterator it = begin; it != end; ++it) {
+        store_little_endian<uint32_t>(os, it->size());
+        os.write(it->data(), it->size());
+    }
+}
+
+/**
+ * Memory mapping of a binary file of keys, which are used without any parsing: the integer keys
+ * are viewed in place by a `KeySpan` (on little-endian machines) and the string keys by
+ * `std::string_view`s, so that the file must outlive them.
+ */
+class KeyFile {
+public:
+    KeyFile(std::string const& filename, KeyFileFormat format)
+        : m_file(std::make_unique<mphf::mapped_file>(filename)), m_format(format) {
+        const uint64_t size = m_file->size();
+        if (format == KeyFileFormat::TEXT) {
+            throw std::invalid_argument("The keys of the `text` format are read by `KeyArena`");
+        } else if (format == KeyFileFormat::STRINGS) {
+            const uint64_t header_bytes = sizeof(string_key_file_magic) + sizeof(uint64_t);
+            if (size < header_bytes || std::memcmp(m_file->data(), string_key_file_magic,
+                                                   sizeof(string_key_file_magic)) != 0) {
+                throw std::runtime_error("`" + filename + "` is not a file of `strings` keys");
+            }
+            m_num_keys = load_little_endian<uint64_t>(m_file->data() + 8);
+            if (m_num_keys > (size - header_bytes) / sizeof(uint64_t)) {
+                throw std::runtime_error("The index of `" + filename + "` is truncated");
+            }
+            m_index = m_file->data() + header_bytes;
+            m_records = m_index + m_num_keys * sizeof(uint64_t);
+        } else {
+            const uint64_t key_bytes = key_file_integer_bytes(format);
+            if (size % key_bytes != 0) {
+                throw std::runtime_error("The size of `" + filename + "` is not a multiple of " +
+                                         std::to_string(key_bytes) + " bytes");
+            }
+            m_num_keys = size / key_bytes;
+        }
+        // the keys are loaded right away, so start reading the file ahead
+        madvise(const_cast<char*>(m_file->data()), size, MADV_WILLNEED);
+    }
+
+    /**
+     * @return The view of the first `num_keys` keys (or of all of them, if 0) of a file of
+     * integers of the size of `T`, whose pages are read right away, so that the first test does
+     * not pay for the reading of the file. On big-endian machines, the keys are converted into a
+     * copy owned by the file.
+     */
+    template <typename T>
+    KeySpan<T> integers(uint64_t num_keys = 0) const {
+        if (key_file_integer_bytes(m_format) != sizeof(T)) {
+            throw std::invalid_argument(std::string("The keys of the `") +
+                                        key_file_format_name(m_format) + "` format are not " +
+                                        std::to_string(8 * sizeof(T)) + "-bit integers");
+        }
+        const uint64_t size = limit(num_keys);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        m_converted.resize(size * sizeof(T));
+        for (uint64_t i = 0; i != size; ++i) {
+            T key = load_little_endian<T>(m_file->data() + i * sizeof(T));
+            std::memcpy(m_converted.data() + i * sizeof(T), &key, sizeof(T));
+        }
+        return {reinterpret_cast<const T*>(m_converted.data()), size};
+#else
+        // the mapping is page aligned, and so are the keys
+        const char* data = m_file->data();
+        volatile char sink = 0;
+        for (uint64_t i = 0; i < size * sizeof(T); i += 4096) sink = sink ^ data[i];
+        return {reinterpret_cast<const T*>(data), size};
+#endif
+    }
+
+    /**
+     * @return Views of the first `num_keys` keys (or of all of them, if 0) of a file of strings
+     */
+    std::vector<std::string_view> strings(uint64_t num_keys = 0) const {
+        if (m_format != KeyFileFormat::STRINGS) {
+            throw std::invalid_argument(std::string("The keys of the `") +
+                                        key_file_format_name(m_format) +
+                                        "` format are not strings");
+        }
+        const uint64_t records_bytes = m_file->data() + m_file->size() - m_records;
+        std::vector<std::string_view> keys(limit(num_keys));
+        for (uint64_t i = 0; i != keys.size(); ++i) {
+            uint64_t offset = load_little_endian<uint64_t>(m_index + i * sizeof(uint64_t));
+            if (offset > records_bytes || records_bytes - offset < sizeof(uint32_t)) {
+                throw std::runtime_error("The record of key " + std::to_string(i) +
+                                         " is out of the file");
+            }
+            uint64_t length = load_little_endian<uint32_t>(m_records + offset);
+            offset += sizeof(uint32_t);
+            if (records_bytes - offset < length) {
+                throw std::runtime_error("The key " + std::to_string(i) + " is truncated");
+            }
+            keys[i] = std::string_view(m_records + offset, length);
+        }
+        return keys;
+    }
+
+    inline KeyFileFormat format() const {
+        return m_format;
+    }
+
+    inline uint64_t num_keys() const {
+        return m_num_keys;
+    }
+
+    /**
+     * @return The number of bytes of the file
+     */
+    inline uint64_t size() const {
+        return m_file->size();
+    }
+
+private:
+    inline uint64_t limit(uint64_t num_keys) const {
+        return num_keys == 0 ? m_num_keys : std::min(num_keys, m_num_keys);
+    }
+
+    std::unique_ptr<mphf::mapped_file> m_file;
+    KeyFileFormat m_format;
+    uint64_t m_num_keys;
+    const char* m_index = nullptr;    // only in the `strings` format
+    const char* m_records = nullptr;  // only in the `strings` format
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    mutable std::vector<char> m_converted;  // integer keys in the native byte order
+#endif
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "key_arena.hpp"
+
+/**
+ * Queue of bounded capacity between threads: `push` waits while the queue is full and `pop` while
+ * it is empty, so that a producer cannot run arbitrarily ahead of its consumers
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(std::max<size_t>(capacity, 1)) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [&] { return m_items.size() < m_capacity; });
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+    }
+
+    /**
+     * @return The oldest item, or nothing if the queue is empty and closed
+     */
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [&] { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) return std::nullopt;
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return item;
+    }
+
+    /**
+     * Tells the consumers that no item follows the queued ones
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    bool m_closed = false;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full, m_not_empty;
+};
+
+/**
+ * Reads the keys of a stream that cannot be mapped (e.g., a pipe) into blocks, where they are
+ * viewed in place by `std::string_view`s, overlapping the reading with the splitting into keys:
+ * the calling thread fills blocks of about `block_size` bytes, each one ending with a delimiter,
+ * and passes them through a queue of `queue_capacity` blocks to `num_threads` threads, which split
+ * them while the next ones are read. The queue bounds the memory of the blocks read ahead. The
+ * threads can also process the keys of each block as soon as they are split (e.g., hash them for
+ * the first phase of a construction), which then overlaps with the reading as well.
+ */
+class PipelinedKeyReader {
+public:
+    struct Stats {
+        uint64_t bytes = 0;
+        uint64_t blocks = 0;
+        double read_seconds = 0;   // time spent by the reader waiting for the stream
+        double split_seconds = 0;  // time spent by the threads splitting, summed over them
+        double block_seconds = 0;  // time spent by the threads processing the split keys
+        double seconds = 0;        // time from the first read to the last split
+    };
+
+    PipelinedKeyReader(unsigned num_threads = 1, uint64_t block_size = uint64_t(1) << 24,
+                       uint64_t queue_capacity = 0)
+        : m_num_threads(std::max(1u, num_threads))
+        , m_block_size(std::max<uint64_t>(block_size, 1))
+        , m_queue_capacity(queue_capacity != 0 ? queue_capacity : 2 * m_num_threads) {}
+
+    // the views of the keys point into the blocks, which are therefore neither copied nor moved
+    PipelinedKeyReader(PipelinedKeyReader const&) = delete;
+    PipelinedKeyReader& operator=(PipelinedKeyReader const&) = delete;
+
+    /**
+     * @return Views of the first `num_keys` keys (or of all of them, if 0) of `is`, separated by
+     * `delimiter` like the lines read by `std::getline`. The reading stops as soon as
+     * `num_keys` keys have been split, possibly a few blocks later than needed.
+     */
+    std::vector<std::string_view> read(std::istream& is, char delimiter = '\n',
+                                       uint64_t num_keys = 0) {
+        return read(is, delimiter, num_keys, [](uint64_t, std::vector<std::string_view> const&) {});
+    }
+
+    /**
+     * Reads the keys as `read(is, delimiter, num_keys)`, calling `on_block(i, keys)` on the
+     * splitting threads with the keys of the i-th block, in no particular order of the blocks, as
+     * soon as they are split. The keys returned are those of the blocks in order, so that the
+     * first `num_keys` keys are in the blocks processed first.
+     */
+    template <typename BlockFunction>
+    std::vector<std::string_view> read(std::istream& is, char delimiter, uint64_t num_keys,
+                                       BlockFunction on_block) {
+        using clock = std::chrono::steady_clock;
+        auto seconds_since = [](clock::time_point start) {
+            return std::chrono::duration<double>(clock::now() - start).count();
+        };
+        const auto start = clock::now();
+        struct Block {
+            uint64_t index;
+            const char* begin;
+            const char* end;
+        };
+        BoundedQueue<Block> queue(m_queue_capacity);
+        std::vector<std::vector<std::string_view>> block_keys;
+        std::mutex block_keys_mutex;
+        std::atomic<uint64_t> num_split_keys(0);
+        std::atomic<uint64_t> split_nanoseconds(0), block_nanoseconds(0);
+        auto nanoseconds_since = [](clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start)
+                .count();
+        };
+
+        auto split = [&]() {
+            while (std::optional<Block> block = queue.pop()) {
+                const auto split_start = clock::now();
+                std::vector<std::string_view> keys;
+                const char* key_begin = block->begin;
+                auto add_keys = [&](const char* begin, uint64_t mask) {
+                    for (; mask != 0; mask &= mask - 1) {
+                        const char* key_end = begin + __builtin_ctzll(mask);
+                        keys.emplace_back(key_begin, key_end - key_begin);
+                        key_begin = key_end + 1;
+                    }
+                };
+                scan_delimiters(block->begin, block->end, delimiter, add_keys);
+                // only the last block can end without a delimiter
+                if (key_begin != block->end) keys.emplace_back(key_begin, block->end - key_begin);
+                split_nanoseconds += nanoseconds_since(split_start);
+                const auto block_start = clock::now();
+                on_block(block->index, keys);
+                block_nanoseconds += nanoseconds_since(block_start);
+                num_split_keys += keys.size();
+                std::lock_guard<std::mutex> lock(block_keys_mutex);
+                if (block_keys.size() <= block->index) block_keys.resize(block->index + 1);
+                block_keys[block->index] = std::move(keys);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i != m_num_threads; ++i) threads.emplace_back(split);
+
+        std::vector<char> tail;  // the beginning of the key cut by the end of the last block
+        uint64_t num_blocks = 0;
+        while (num_keys == 0 || num_split_keys < num_keys) {
+            std::vector<char> block(tail.size() + m_block_size);
+            std::copy(tail.begin(), tail.end(), block.begin());
+            const auto read_start = clock::now();
+            is.read(block.data() + tail.size(), m_block_size);
+            m_stats.read_seconds += seconds_since(read_start);
+            const uint64_t num_read = is.gcount();
+            m_stats.bytes += num_read;
+            uint64_t size = tail.size() + num_read;
+            const bool last = !is;
+            if (!last) {
+                // cut the block after its last delimiter and carry the rest over to the next one
+                uint64_t end = size;
+                while (end != 0 && block[end - 1] != delimiter) --end;
+                tail.assign(block.begin() + end, block.begin() + size);
+                if (end == 0) continue;  // the block is a part of a single key
+                size = end;
+            }
+            if (size != 0) {
+                block.resize(size);
+                m_blocks.push_back(std::move(block));  // the data of the block does not move
+                queue.push({num_blocks++, m_blocks.back().data(), m_blocks.back().data() + size});
+            }
+            if (last) break;
+        }
+        queue.close();
+        for (auto& thread : threads) thread.join();
+
+        uint64_t count = num_split_keys;
+        if (num_keys != 0) count = std::min(count, num_keys);
+        std::vector<std::string_view> keys;
+        keys.reserve(count);
+        for (auto const& block : block_keys) {
+            uint64_t n = std::min<uint64_t>(block.size(), count - keys.size());
+            keys.insert(keys.end(), block.begin(), block.begin() + n);
+        }
+        m_stats.blocks += num_blocks;
+        m_stats.split_seconds += split_nanoseconds / 1e9;
+        m_stats.block_seconds += block_nanoseconds / 1e9;
+        m_stats.seconds += seconds_since(start);
+        return keys;
+    }
+
+    inline Stats const& stats() const {
+        return m_stats;
+    }
+
+    inline unsigned num_threads() const {
+        return m_num_threads;
+    }
+
+private:
+    const unsigned m_num_threads;
+    const uint64_t m_block_size;
+    const uint64_t m_queue_capacity;
+    std::vector<std::vector<char>> m_blocks;
+    Stats m_stats;
+};
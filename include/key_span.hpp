@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Read-only view of a contiguous sequence of keys, e.g., of a prefix of a vector of keys, so that
+ * the structures can be built and tested on part of the keys without copying them
+ */
+template <typename T>
+class KeySpan {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+    using iterator = const_iterator;
+
+    KeySpan() : m_data(nullptr), m_size(0) {}
+
+    KeySpan(const T* data, uint64_t size) : m_data(data), m_size(size) {}
+
+    template <typename Allocator>
+    KeySpan(std::vector<T, Allocator> const& keys) : m_data(keys.data()), m_size(keys.size()) {}
+
+    /**
+     * @return The view of the first `size` keys
+     */
+    KeySpan prefix(uint64_t size) const {
+        if (size > m_size) throw std::out_of_range("The prefix is longer than the keys");
+        return {m_data, size};
+    }
+
+    inline const T* data() const {
+        return m_data;
+    }
+
+    inline uint64_t size() const {
+        return m_size;
+    }
+
+    inline bool empty() const {
+        return m_size == 0;
+    }
+
+    inline const_iterator begin() const {
+        return m_data;
+    }
+
+    inline const_iterator end() const {
+        return m_data + m_size;
+    }
+
+    inline T const& front() const {
+        return m_data[0];
+    }
+
+    inline T const& operator[](uint64_t i) const {
+        return m_data[i];
+    }
+
+private:
+    const T* m_data;
+    uint64_t m_size;
+};
+
+/**
+ * Removes the last `num_keys` keys from the view `keys`, as `split_tail_keys` does for a vector,
+ * without copying them
+ * @return The view of the removed keys
+ */
+template <typename T>
+KeySpan<T> split_tail_keys(KeySpan<T>& keys, uint64_t num_keys) {
+    if (num_keys > keys.size()) {
+        throw std::invalid_argument("Cannot split more keys than the available ones");
+    }
+    KeySpan<T> tail(keys.data() + keys.size() - num_keys, num_keys);
+    keys = keys.prefix(keys.size() - num_keys);
+    return tail;
+}
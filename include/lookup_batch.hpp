@@ -0,0 +1,34 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+namespace mphf {
+
+/**
+ * Whether `MPHF` implements `lookup_batch(begin, end, out)` natively (as `FCH`), e.g., to overlap
+ * the memory accesses of the keys of a batch
+ */
+template <typename MPHF, typename Iterator, typename OutputIterator, typename = void>
+struct has_lookup_batch : std::false_type {};
+
+template <typename MPHF, typename Iterator, typename OutputIterator>
+struct has_lookup_batch<MPHF, Iterator, OutputIterator,
+                        std::void_t<decltype(std::declval<MPHF const&>().lookup_batch(
+                            std::declval<Iterator>(), std::declval<Iterator>(),
+                            std::declval<OutputIterator>()))>> : std::true_type {};
+
+/**
+ * Looks up the keys in [begin, end) with `mphf`, writing their positions to `out`: through the
+ * native `lookup_batch` of the structure if it has one, or one key at a time otherwise
+ */
+template <typename MPHF, typename Iterator, typename OutputIterator>
+void lookup_batch(MPHF const& mphf, Iterator begin, Iterator end, OutputIterator out) {
+    if constexpr (has_lookup_batch<MPHF, Iterator, OutputIterator>::value) {
+        mphf.lookup_batch(begin, end, out);
+    } else {
+        for (; begin != end; ++begin, ++out) { *out = mphf(*begin); }
+    }
+}
+
+}  // namespace mphf
@@ -2,6 +2,13 @@
 
 #include <fcntl.h>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "serialization.hpp"
+#include "utils.hpp"
 
 #include "../external/pthash/include/pthash.hpp"
 #include "../external/pthash/include/encoders/encoders.hpp"
@@ -9,6 +16,25 @@
 
 namespace mphf {
 
+/**
+ * The hasher of PTHash, extended to the keys viewed by `std::string_view`, which are hashed as the
+ * `std::string`s of the same characters, and to the 128-bit keys, which would otherwise be
+ * truncated to 64 bits
+ */
+struct pthash_hasher : pthash::murmurhash2_64 {
+    using pthash::murmurhash2_64::hash;
+
+    static inline pthash::hash64 hash(std::string_view val, uint64_t seed) {
+        return pthash::MurmurHash2_64(val.data(), val.size(), seed);
+    }
+
+    // a template, so that the narrower integers still convert to uint64_t without ambiguity
+    template <typename T, typename = std::enable_if_t<std::is_same_v<T, __uint128_t>>>
+    static inline pthash::hash64 hash(T const& val, uint64_t seed) {
+        return pthash::MurmurHash2_64(&val, sizeof(val), seed);
+    }
+};
+
 template <bool partitioned, typename Encoder>
 struct PTHashWrapper {
     struct Builder {
@@ -46,16 +72,16 @@ struct PTHashWrapper {
         }
 
         template <typename T>
-        PTHashWrapper build(const std::vector<T>& keys, uint64_t seed = 0,
-                            bool verbose = false) const {
+        PTHashWrapper build(KeySpan<T> keys, uint64_t seed = 0,
+                            bool verbose = false, BuildStats* stats = nullptr) const {
             PTHashWrapper pthash_wrapper;
-            build(pthash_wrapper, keys, seed, verbose);
+            build(pthash_wrapper, keys, seed, verbose, stats);
             return pthash_wrapper;
         }
 
         template <typename T>
-        void build(PTHashWrapper& pthash_wrapper, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(PTHashWrapper& pthash_wrapper, KeySpan<T> keys, uint64_t seed = 0,
+                   bool verbose = false, BuildStats* stats = nullptr) const {
             pthash::build_configuration config;
             config.c = m_c;
             config.alpha = m_alpha;
@@ -65,22 +91,45 @@ struct PTHashWrapper {
             config.verbose_output = verbose;
             config.seed = seed;
 
+            Chrono chrono;
             if constexpr (!partitioned) {
+                chrono.start();
                 uint64_t num_bytes_for_construction = pthash::internal_memory_builder_single_phf<
-                    pthash::murmurhash2_64>::estimate_num_bytes_for_construction(keys.size(),
-                                                                                 config);
-                std::cout << "Estimated num_bytes for construction: " << num_bytes_for_construction
+                    pthash_hasher>::estimate_num_bytes_for_construction(keys.size(), config);
+                chrono.stop();
+                if (stats) stats->add_phase("estimate", chrono.elapsed_time());
+                std::cerr << "Estimated num_bytes for construction: " << num_bytes_for_construction
                           << " (" << static_cast<double>(num_bytes_for_construction) / keys.size()
                           << " bytes/key)" << std::endl;
             }
 
-            pthash_wrapper.m_pthash.build_in_internal_memory(keys.begin(), keys.size(), config);
+            auto timings =
+                pthash_wrapper.m_pthash.build_in_internal_memory(keys.begin(), keys.size(), config);
+            if (stats) {
+                if constexpr (partitioned) {
+                    stats->add_phase("partitioning", timings.partitioning_seconds);
+                }
+                stats->add_phase("mapping_ordering", timings.mapping_ordering_seconds);
+                stats->add_phase("searching", timings.searching_seconds);
+                stats->add_phase("encoding", timings.encoding_seconds);
+            }
         }
 
         std::string name() const {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return m_num_threads;
+        }
+
+        /**
+         * @return true if the structure depends on the seed passed to `build`
+         */
+        bool seeded() const {
+            return true;
+        }
+
     private:
         float m_c, m_alpha;
         std::string m_name;
@@ -97,9 +146,23 @@ struct PTHashWrapper {
         return m_pthash.num_bits();
     }
 
+    // PTHash saves to and loads from named files only, so the structure goes through a temporary
+    // in-memory file
+    void save(std::ostream& os) const {
+        save_through_path(os, [&](std::string const& path) {
+            essentials::save(const_cast<decltype(m_pthash)&>(m_pthash), path.c_str());
+        });
+    }
+
+    void load(std::istream& is) {
+        load_through_path(is, [&](std::string const& path) {
+            essentials::load(m_pthash, path.c_str());
+        });
+    }
+
 private:
-    std::conditional_t<partitioned, pthash::partitioned_phf<pthash::murmurhash2_64, Encoder, true>,
-                       pthash::single_phf<pthash::murmurhash2_64, Encoder, true> >
+    std::conditional_t<partitioned, pthash::partitioned_phf<pthash_hasher, Encoder, true>,
+                       pthash::single_phf<pthash_hasher, Encoder, true> >
         m_pthash;
 };
 
@@ -2,6 +2,11 @@
 
 #include <fcntl.h>
 #include <sstream>
+#include <string_view>
+
+#include "build_stats.hpp"
+#include "key_span.hpp"
+#include "utils.hpp"
 
 #include "../external/sux/sux/function/RecSplit.hpp"
 
@@ -20,38 +25,57 @@ public:
         }
 
         template <typename T>
-        RecSplitWrapper build(const std::vector<T>& keys, uint64_t seed = 0,
-                              bool verbose = false) const {
+        RecSplitWrapper build(KeySpan<T> keys, uint64_t seed = 0,
+                              bool verbose = false, BuildStats* stats = nullptr) const {
             RecSplitWrapper recsplit_wrapper;
-            build(recsplit_wrapper, keys, seed, verbose);
+            build(recsplit_wrapper, keys, seed, verbose, stats);
             return recsplit_wrapper;
         }
 
         template <typename T>
-        void build(RecSplitWrapper& recsplit_wrapper, const std::vector<T>& keys, uint64_t seed = 0,
-                   bool verbose = false) const {
+        void build(RecSplitWrapper& recsplit_wrapper, KeySpan<T> keys, uint64_t seed = 0,
+                   bool verbose = false, BuildStats* stats = nullptr) const {
+            Chrono chrono;
             if (verbose) { std::cerr << "\tstarted remapping" << std::endl; }
+            chrono.start();
             std::vector<hash128_t> remapped_keys;
             remapped_keys.reserve(keys.size());
+            recsplit_wrapper.set_seed(seed);
             for (size_t i = 0, i_end = keys.size(); i < i_end; ++i) {
-                remapped_keys.push_back(adapt_key(keys[i]));
+                remapped_keys.push_back(recsplit_wrapper.adapt_key(keys[i]));
             }
+            chrono.stop();
+            if (stats) stats->add_phase("remapping", chrono.elapsed_time());
             if (verbose) { std::cerr << "\tconstruction started" << std::endl; }
+            chrono.reset_and_start();
             recsplit_wrapper.m_recsplit =
                 sux::function::RecSplit<LEAF_SIZE, AT>(remapped_keys, m_bucket_size);
+            chrono.stop();
+            if (stats) stats->add_phase("construction", chrono.elapsed_time());
         }
 
         std::string name() const {
             return m_name;
         }
 
+        uint64_t num_threads() const {
+            return 1;
+        }
+
+        /**
+         * @return true if the structure depends on the seed passed to `build`
+         */
+        bool seeded() const {
+            return true;
+        }
+
     private:
         uint64_t m_bucket_size;
         std::string m_name;
     };
 
     template <typename T>
-    inline uint64_t operator()(const T& key) {  // this should be const but `lookup` is not const
+    inline uint64_t operator()(const T& key) const {
         return m_recsplit(adapt_key(key));
     }
 
@@ -62,20 +86,60 @@ public:
         return 8 * ss.tellg();
     }
 
+    void save(std::ostream& os) const {
+        os.write(reinterpret_cast<const char*>(&m_seed), sizeof(m_seed));
+        os << m_recsplit;
+    }
+
+    void load(std::istream& is) {
+        uint64_t seed;
+        is.read(reinterpret_cast<char*>(&seed), sizeof(seed));
+        set_seed(seed);
+        is >> m_recsplit;
+    }
+
 private:
     using hash128_t = sux::function::hash128_t;
 
+    /**
+     * RecSplit searches its bijections from fixed seeds, so the seed of the construction changes
+     * the 128-bit hashes of the keys instead: both halves are xored with a mix of the seed, which
+     * keeps the hashes distinct and leaves them unchanged for the seed 0
+     */
+    void set_seed(uint64_t seed) {
+        auto mix = [](uint64_t x) {  // the finalizer of SplitMix64
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        };
+        m_seed = seed;
+        m_seed_mask = seed == 0 ? hash128_t{0, 0} : hash128_t{mix(seed), mix(~seed)};
+    }
+
+    inline hash128_t seeded(hash128_t hash) const {
+        return {hash.first ^ m_seed_mask.first, hash.second ^ m_seed_mask.second};
+    }
+
     template <typename T>
-    static inline hash128_t adapt_key(T const& key) {
-        return sux::function::first_hash(&key, sizeof(T));
+    inline hash128_t adapt_key(T const& key) const {
+        return seeded(sux::function::first_hash(&key, sizeof(T)));
     }
 
     //    template <>
-    static inline hash128_t adapt_key(std::string const& key) {
-        return sux::function::first_hash(key.data(), key.size());
+    inline hash128_t adapt_key(std::string const& key) const {
+        return seeded(sux::function::first_hash(key.data(), key.size()));
+    }
+
+    inline hash128_t adapt_key(std::string_view key) const {
+        return seeded(sux::function::first_hash(key.data(), key.size()));
     }
 
-    sux::function::RecSplit<LEAF_SIZE, AT> m_recsplit;
+    uint64_t m_seed = 0;
+    hash128_t m_seed_mask = {0, 0};
+
+    // `operator()` is not declared const, although it only reads the structure (the Golomb-Rice
+    // reader is a local copy) and is safe to call concurrently
+    mutable sux::function::RecSplit<LEAF_SIZE, AT> m_recsplit;
 };
 
 }  // namespace mphf
\ No newline at end of file
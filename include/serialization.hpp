@@ -0,0 +1,451 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include <unistd.h>
+
+namespace mphf {
+
+/**
+ * Visitors that serialize the structures exposing a `visit(Visitor&)` method (as `FCH`).
+ * Values are stored with their native representation and padded to multiples of 8 bytes, and each
+ * array is stored as its number of elements followed by its elements and by a zero word, so that
+ * unaligned 64-bit reads past the last element (as in `compact_vector::access`) stay in bounds.
+ * Since the header of a saved file is also a multiple of 8 bytes, the arrays of a memory-mapped
+ * file are suitably aligned to be used in place by the `mapper`.
+ */
+struct saver {
+    saver(std::ostream& os) : m_os(os), m_bytes(0) {}
+
+    template <typename T>
+    void visit(T& value) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            write(&value, sizeof(T));
+        } else {
+            value.visit(*this);
+        }
+    }
+
+    /**
+     * Visits an array, either owned by `owned` or viewed by `view` (pointing to `size` elements)
+     */
+    template <typename T, typename Allocator>
+    void visit_array(std::vector<T, Allocator>& /* owned */, T const*& view, uint64_t size) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&size, sizeof(size));
+        write(view, size * sizeof(T));
+        uint64_t guard = 0;
+        write(&guard, sizeof(guard));
+    }
+
+    inline uint64_t bytes() const {
+        return m_bytes;
+    }
+
+private:
+    void write(const void* data, uint64_t num_bytes) {
+        static const char padding[8] = {0};
+        m_os.write(reinterpret_cast<const char*>(data), num_bytes);
+        m_os.write(padding, (8 - num_bytes % 8) % 8);
+        if (!m_os) throw std::runtime_error("Error while writing the structure");
+        m_bytes += (num_bytes + 7) / 8 * 8;
+    }
+
+    std::ostream& m_os;
+    uint64_t m_bytes;
+};
+
+/**
+ * Reads what `saver` writes, copying the arrays into memory owned by the structure
+ */
+struct loader {
+    loader(std::istream& is) : m_is(is) {}
+
+    template <typename T>
+    void visit(T& value) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            read(&value, sizeof(T));
+        } else {
+            value.visit(*this);
+        }
+    }
+
+    template <typename T, typename Allocator>
+    void visit_array(std::vector<T, Allocator>& owned, T const*& view, uint64_t /* size */) {
+        uint64_t size = 0;
+        read(&size, sizeof(size));
+        owned.resize(size);
+        read(owned.data(), size * sizeof(T));
+        uint64_t guard;
+        read(&guard, sizeof(guard));
+        view = owned.data();
+    }
+
+private:
+    void read(void* data, uint64_t num_bytes) {
+        char padding[8];
+        m_is.read(reinterpret_cast<char*>(data), num_bytes);
+        m_is.read(padding, (8 - num_bytes % 8) % 8);
+        if (!m_is) throw std::runtime_error("Unexpected end of the saved structure");
+    }
+
+    std::istream& m_is;
+};
+
+/**
+ * Reads what `saver` writes from memory (e.g., a memory-mapped file) without copying the arrays:
+ * the structure points into the memory, which must outlive it
+ */
+struct mapper {
+    mapper(const char* begin, const char* end) : m_cur(begin), m_end(end) {}
+
+    template <typename T>
+    void visit(T& value) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            memcpy(&value, advance(sizeof(T)), sizeof(T));
+        } else {
+            value.visit(*this);
+        }
+    }
+
+    template <typename T, typename Allocator>
+    void visit_array(std::vector<T, Allocator>& owned, T const*& view, uint64_t /* size */) {
+        uint64_t size = 0;
+        memcpy(&size, advance(sizeof(size)), sizeof(size));
+        owned.clear();
+        owned.shrink_to_fit();
+        view = reinterpret_cast<T const*>(advance(size * sizeof(T)));
+        advance(sizeof(uint64_t));  // guard
+    }
+
+    inline const char* position() const {
+        return m_cur;
+    }
+
+private:
+    const char* advance(uint64_t num_bytes) {
+        const char* data = m_cur;
+        uint64_t padded_bytes = (num_bytes + 7) / 8 * 8;
+        if (padded_bytes > static_cast<uint64_t>(m_end - m_cur)) {
+            throw std::runtime_error("Unexpected end of the saved structure");
+        }
+        m_cur += padded_bytes;
+        return data;
+    }
+
+    const char* m_cur;
+    const char* m_end;
+};
+
+/**
+ * Header of the files written by the benchmark: it identifies the algorithm (the name of its
+ * builder, including the parameters), the type and number of keys of the saved structure.
+ * Its size is a multiple of 8 bytes.
+ */
+struct file_header {
+    static constexpr uint64_t magic = 0x5448504d42484d50;  // "PMHBMPHT"
+    // 2: the BBhash and RecSplit structures start with their seed
+    static constexpr uint64_t version = 2;
+
+    std::string algorithm;
+    std::string key_type;
+    uint64_t num_keys = 0;
+
+    void save(std::ostream& os) const {
+        write_word(os, magic);
+        write_word(os, version);
+        write_string(os, algorithm);
+        write_string(os, key_type);
+        write_word(os, num_keys);
+        if (!os) throw std::runtime_error("Error while writing the file header");
+    }
+
+    void load(std::istream& is) {
+        if (read_word(is) != magic) {
+            throw std::runtime_error(
+                "The file does not contain a structure saved by the benchmark");
+        }
+        if (read_word(is) != version) {
+            throw std::runtime_error("Unsupported version of the saved structure");
+        }
+        algorithm = read_string(is);
+        key_type = read_string(is);
+        num_keys = read_word(is);
+        if (!is) throw std::runtime_error("Truncated file header");
+    }
+
+private:
+    static void write_word(std::ostream& os, uint64_t word) {
+        os.write(reinterpret_cast<const char*>(&word), sizeof(word));
+    }
+
+    static uint64_t read_word(std::istream& is) {
+        uint64_t word = 0;
+        is.read(reinterpret_cast<char*>(&word), sizeof(word));
+        return word;
+    }
+
+    static void write_string(std::ostream& os, std::string const& str) {
+        write_word(os, str.size());
+        std::string padded = str;
+        padded.resize((str.size() + 7) / 8 * 8, '\0');
+        os.write(padded.data(), padded.size());
+    }
+
+    static std::string read_string(std::istream& is) {
+        uint64_t size = read_word(is);
+        if (!is || size > (uint64_t(1) << 20)) throw std::runtime_error("Corrupted file header");
+        std::string str((size + 7) / 8 * 8, '\0');
+        is.read(&str[0], str.size());
+        str.resize(size);
+        return str;
+    }
+};
+
+/**
+ * Whether `MPHF` can be loaded in place from memory, by `map(begin, end)`
+ */
+template <typename MPHF, typename = void>
+struct has_map : std::false_type {};
+
+template <typename MPHF>
+struct has_map<MPHF, std::void_t<decltype(std::declval<MPHF&>().map(
+                         std::declval<const char*>(), std::declval<const char*>()))>>
+    : std::true_type {};
+
+/**
+ * Removes the pages of `filename` from the page cache (as far as they are clean and not mapped),
+ * so that the next read of the file comes from the storage device
+ */
+inline void evict_file_pages(std::string const& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) return;
+#ifdef __linux__
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+    fsync(fd);  // the pages cannot be evicted, so the next read may still hit the page cache
+#endif
+    close(fd);
+}
+
+/**
+ * Read-only memory mapping of a whole file
+ */
+class mapped_file {
+public:
+    mapped_file(std::string const& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) throw std::runtime_error("Unable to open `" + filename + "`");
+        struct stat st;
+        if (fstat(fd, &st) == -1 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Unable to map the empty file `" + filename + "`");
+        }
+        m_size = st.st_size;
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) throw std::runtime_error("Unable to map `" + filename + "`");
+        m_data = static_cast<const char*>(data);
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    ~mapped_file() {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    inline const char* data() const {
+        return m_data;
+    }
+
+    inline uint64_t size() const {
+        return m_size;
+    }
+
+private:
+    const char* m_data;
+    uint64_t m_size;
+};
+
+/**
+ * Input stream buffer reading a range of memory, used to deserialize from a memory mapping the
+ * structures that can only be read from a stream
+ */
+struct memory_streambuf : std::streambuf {
+    memory_streambuf(const char* begin, const char* end) {
+        char* data = const_cast<char*>(begin);
+        setg(data, data, const_cast<char*>(end));
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which = std::ios_base::in) override {
+        if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+        char* target = dir == std::ios_base::beg   ? eback() + off
+                       : dir == std::ios_base::cur ? gptr() + off
+                                                   : egptr() + off;
+        if (target < eback() || target > egptr()) return pos_type(off_type(-1));
+        setg(eback(), target, egptr());
+        return pos_type(target - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+/**
+ * Temporary file with a path, which is anonymous and in memory on Linux (a `memfd`), and a file
+ * of the temporary directory removed on destruction elsewhere
+ */
+struct temporary_file {
+    temporary_file() {
+#ifdef __linux__
+        fd = static_cast<int>(syscall(SYS_memfd_create, "mphf", 0));
+        if (fd != -1) path = "/proc/self/fd/" + std::to_string(fd);
+#else
+        const char* directory = std::getenv("TMPDIR");
+        std::string pattern = std::string(directory ? directory : "/tmp") + "/mphf.XXXXXX";
+        fd = mkstemp(&pattern[0]);
+        if (fd != -1) {
+            path = pattern;
+            m_named = true;
+        }
+#endif
+        if (fd == -1) throw std::runtime_error("Unable to create a temporary file");
+    }
+
+    temporary_file(temporary_file const&) = delete;
+    temporary_file& operator=(temporary_file const&) = delete;
+
+    ~temporary_file() {
+        close(fd);
+        if (m_named) unlink(path.c_str());
+    }
+
+    int fd = -1;
+    std::string path;
+
+private:
+    bool m_named = false;
+};
+
+/**
+ * Writes to `os` (prefixed by its length) what `save_to_path` writes to the path it is given,
+ * for the libraries that can only save to a named file
+ */
+template <typename SaveToPath>
+void save_through_path(std::ostream& os, SaveToPath save_to_path) {
+    temporary_file file;
+    const int fd = file.fd;
+    save_to_path(file.path);
+    uint64_t size = lseek(fd, 0, SEEK_END);
+    lseek(fd, 0, SEEK_SET);
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    std::vector<char> buffer(1 << 20);
+    for (uint64_t copied = 0; copied < size;) {
+        ssize_t num_read = read(fd, buffer.data(), buffer.size());
+        if (num_read <= 0) break;
+        os.write(buffer.data(), num_read);
+        copied += num_read;
+    }
+    if (!os) throw std::runtime_error("Error while writing the structure");
+}
+
+/**
+ * Reads what `save_through_path` writes, passing it to `load_from_path` as a named file
+ */
+template <typename LoadFromPath>
+void load_through_path(std::istream& is, LoadFromPath load_from_path) {
+    uint64_t size = 0;
+    is.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!is) throw std::runtime_error("Unexpected end of the saved structure");
+    temporary_file file;
+    std::vector<char> buffer(1 << 20);
+    for (uint64_t copied = 0; copied < size;) {
+        uint64_t chunk = std::min<uint64_t>(buffer.size(), size - copied);
+        is.read(buffer.data(), chunk);
+        if (!is || write(file.fd, buffer.data(), chunk) != static_cast<ssize_t>(chunk)) {
+            throw std::runtime_error("Unexpected end of the saved structure");
+        }
+        copied += chunk;
+    }
+    load_from_path(file.path);
+}
+
+/**
+ * Reads what `fwrite`-based `dump` writes to a `FILE*`, prefixed by its length
+ */
+template <typename Dump>
+void save_through_file(std::ostream& os, Dump dump) {
+#ifdef __linux__
+    char* data = nullptr;
+    size_t size = 0;
+    FILE* file = open_memstream(&data, &size);
+    if (!file) throw std::runtime_error("Unable to create a memory stream");
+    dump(file);
+    fclose(file);
+    uint64_t size64 = size;
+    os.write(reinterpret_cast<const char*>(&size64), sizeof(size64));
+    os.write(data, size);
+    free(data);
+#else
+    FILE* file = std::tmpfile();
+    if (!file) throw std::runtime_error("Unable to create a temporary file");
+    dump(file);
+    fflush(file);
+    uint64_t size64 = std::ftell(file);
+    std::rewind(file);
+    os.write(reinterpret_cast<const char*>(&size64), sizeof(size64));
+    std::vector<char> buffer(1 << 20);
+    for (size_t num_read; (num_read = std::fread(buffer.data(), 1, buffer.size(), file)) != 0;) {
+        os.write(buffer.data(), num_read);
+    }
+    fclose(file);
+#endif
+    if (!os) throw std::runtime_error("Error while writing the structure");
+}
+
+/**
+ * Reads what `save_through_file` writes, passing it to `load` as a `FILE*`
+ */
+template <typename Load>
+void load_through_file(std::istream& is, Load load) {
+    uint64_t size = 0;
+    is.read(reinterpret_cast<char*>(&size), sizeof(size));
+    std::vector<char> data(size);
+    is.read(data.data(), size);
+    if (!is || size == 0) throw std::runtime_error("Unexpected end of the saved structure");
+#ifdef __linux__
+    FILE* file = fmemopen(data.data(), size, "rb");
+    if (!file) throw std::runtime_error("Unable to create a memory stream");
+#else
+    FILE* file = std::tmpfile();
+    if (!file) throw std::runtime_error("Unable to create a temporary file");
+    std::fwrite(data.data(), 1, size, file);
+    std::rewind(file);
+#endif
+    load(file);
+    fclose(file);
+}
+
+}  // namespace mphf
@@ -7,12 +7,15 @@
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <random>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string.h>
 #include <sys/time.h>
 #include <unordered_set>
+#include <vector>
 
 /**
  * @author: Folly
@@ -76,6 +79,21 @@ public:
         return m_labels_durations.size();
     }
 
+    /**
+     * @return The duration in seconds of each measurement, in order of measurement
+     */
+    inline std::vector<double> durations() const {
+        std::vector<double> result;
+        result.reserve(m_labels_durations.size());
+        for (auto const& entry : m_labels_durations) {
+            result.push_back(
+                static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(entry.duration).count()) /
+                1e9);
+        }
+        return result;
+    }
+
 private:
     using ClockType = std::chrono::steady_clock;
 
@@ -202,6 +220,53 @@ std::vector<T> create_random_distinct_keys(uint64_t num_keys, uint64_t seed) {
     return keys;
 }
 
+/**
+ * Creates `num_keys` distinct random keys that do not belong to `members`, drawing them from the
+ * same distribution used by `create_random_distinct_keys`.
+ */
+template <typename T>
+std::vector<T> create_random_non_member_keys(std::vector<T> const& members, uint64_t num_keys,
+                                             uint64_t seed) {
+    std::mt19937_64 random_generator(~seed + num_keys);
+    std::vector<T> sorted_members(members);
+    std::sort(sorted_members.begin(), sorted_members.end());
+
+    std::vector<T> keys;
+    std::vector<T> candidates;
+    while (keys.size() < num_keys) {
+        candidates.resize(num_keys - keys.size() + (num_keys - keys.size()) * 0.25);
+        std::generate(candidates.begin(), candidates.end(), random_generator);
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        // keep the candidates that are neither members nor already selected
+        uint64_t curr_size = keys.size();
+        std::set_difference(candidates.begin(), candidates.end(), sorted_members.begin(),
+                            sorted_members.end(), std::back_inserter(keys));
+        std::inplace_merge(keys.begin(), keys.begin() + curr_size, keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    std::shuffle(keys.begin(), keys.end(), random_generator);
+    keys.resize(num_keys);
+
+    return keys;
+}
+
+/**
+ * Moves the last `num_keys` keys of `keys` into a new vector, which is returned
+ */
+template <typename T>
+std::vector<T> split_tail_keys(std::vector<T>& keys, uint64_t num_keys) {
+    if (num_keys > keys.size()) {
+        throw std::invalid_argument("Cannot split more keys than the available ones");
+    }
+    std::vector<T> tail(std::make_move_iterator(keys.end() - num_keys),
+                        std::make_move_iterator(keys.end()));
+    keys.resize(keys.size() - num_keys);
+    return tail;
+}
+
 std::vector<uint32_t> create_xorshift32_keys(uint32_t num_keys, uint32_t seed) {
     if (seed == 0) seed = 1234;
     std::vector<uint32_t> result;
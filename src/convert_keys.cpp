@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../include/key_arena.hpp"
+#include "../include/key_file.hpp"
+#include "../include/utils.hpp"
+#include "../external/cmd_line_parser/include/parser.hpp"
+
+/**
+ * Writes the keys as raw little-endian integers of the size of `T`
+ */
+template <typename T>
+void write_integer_keys(std::ostream& os, std::vector<std::string_view> const& keys) {
+    for (uint64_t i = 0; i != keys.size(); ++i) {
+        try {
+            store_little_endian(os, parse_integer_key<T>(keys[i]));
+        } catch (std::invalid_argument const& e) {
+            throw std::invalid_argument(std::string(e.what()) + " at line " +
+                                        std::to_string(i + 1));
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    cmd_line_parser::parser parser(argc, argv);
+    parser.add("output", "The file of keys to write.");
+    parser.add("format",
+               "Format of the written keys, one of: `u32`, `u64`, `u128` (raw arrays of "
+               "little-endian integers, converted from the decimal integers of the lines), "
+               "`strings` (length-prefixed strings with an index).",
+               "--format", false);
+    parser.add("input",
+               "Read the keys from this file, one per line. (default: the keys are read from "
+               "stdin)",
+               "--input", false);
+    parser.add("threads",
+               "Number of threads splitting the file of --input into keys. (default: all the "
+               "hardware threads)",
+               "--threads", false);
+    if (!parser.parse()) { return 1; }
+
+    std::string output = parser.get<std::string>("output");
+    KeyFileFormat format = KeyFileFormat::STRINGS;
+    try {
+        if (parser.parsed("format")) {
+            format = parse_key_file_format(parser.get<std::string>("format"));
+        }
+        if (format == KeyFileFormat::TEXT) {
+            throw std::invalid_argument("The keys are already in the `text` format");
+        }
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    unsigned num_threads = parser.parsed("threads")
+                               ? parser.get<unsigned>("threads")
+                               : std::max(1u, std::thread::hardware_concurrency());
+
+    Chrono chrono;
+    chrono.start();
+    std::unique_ptr<KeyArena> arena;
+    try {
+        if (parser.parsed("input")) {
+            arena = std::make_unique<KeyArena>(parser.get<std::string>("input"));
+        } else {
+            arena = std::make_unique<KeyArena>(std::cin);
+        }
+    } catch (std::runtime_error const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    std::vector<std::string_view> keys = arena->split('\n', 0, num_threads);
+
+    std::ofstream os(output, std::ios::binary);
+    if (!os) {
+        std::cerr << "Unable to open `" << output << "`." << std::endl;
+        return 1;
+    }
+    try {
+        switch (format) {
+            case KeyFileFormat::U32:
+                write_integer_keys<uint32_t>(os, keys);
+                break;
+            case KeyFileFormat::U64:
+                write_integer_keys<uint64_t>(os, keys);
+                break;
+            case KeyFileFormat::U128:
+                write_integer_keys<__uint128_t>(os, keys);
+                break;
+            default:
+                write_string_key_file(os, keys.begin(), keys.end());
+        }
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        os.close();
+        std::remove(output.c_str());  // do not leave a truncated file of keys
+        return 1;
+    }
+    os.close();
+    if (!os) {
+        std::cerr << "Unable to write `" << output << "`." << std::endl;
+        return 1;
+    }
+    chrono.stop();
+    std::cerr << "Converted " << keys.size() << " keys (" << arena->size() << " bytes) into "
+              << output << " (" << key_file_format_name(format) << " format) in "
+              << std::round(chrono.elapsed_time() * 1000) / 1000 << "s" << std::endl;
+    return 0;
+}
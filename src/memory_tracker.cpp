@@ -0,0 +1,177 @@
+// Replacements of the global allocation functions that keep track of the heap usage, reported by
+// the `--memory` option of the benchmark. The usable size of each block is counted, so that the
+// sized and unsized deallocation functions agree. Until `heap_usage::enable` is called, they only
+// forward to `malloc` and `free`, so that the other tests do not pay for the accounting.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+#include <malloc.h>
+#define MPHF_USABLE_SIZE malloc_usable_size
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define MPHF_USABLE_SIZE malloc_size
+#endif
+
+#include "../include/benchmark_utils/memory_tracker.hpp"
+
+namespace {
+
+std::atomic<bool> g_enabled{false};
+std::atomic<int64_t> g_current_bytes{0};
+std::atomic<int64_t> g_peak_bytes{0};
+
+inline void* track_allocation(void* ptr) {
+#ifdef MPHF_USABLE_SIZE
+    if (ptr == nullptr || !g_enabled.load(std::memory_order_relaxed)) return ptr;
+    int64_t size = MPHF_USABLE_SIZE(ptr);
+    int64_t current = g_current_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t peak = g_peak_bytes.load(std::memory_order_relaxed);
+    while (current > peak &&
+           !g_peak_bytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+#endif
+    return ptr;
+}
+
+inline void track_deallocation(void* ptr) {
+#ifdef MPHF_USABLE_SIZE
+    if (ptr != nullptr && g_enabled.load(std::memory_order_relaxed)) {
+        g_current_bytes.fetch_sub(MPHF_USABLE_SIZE(ptr), std::memory_order_relaxed);
+    }
+#endif
+    free(ptr);
+}
+
+inline void* allocate(std::size_t size) {
+    return track_allocation(malloc(size == 0 ? 1 : size));
+}
+
+inline void* allocate(std::size_t size, std::align_val_t alignment) {
+    void* ptr = nullptr;
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    if (posix_memalign(&ptr, align, size == 0 ? 1 : size) != 0) return nullptr;
+    return track_allocation(ptr);
+}
+
+template <typename... Alignment>
+inline void* allocate_or_throw(std::size_t size, Alignment... alignment) {
+    while (true) {
+        void* ptr = allocate(size, alignment...);
+        if (ptr != nullptr) return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) throw std::bad_alloc();
+        handler();
+    }
+}
+
+}  // namespace
+
+namespace heap_usage {
+
+bool enable() {
+#ifdef MPHF_USABLE_SIZE
+    g_enabled.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    return false;
+#endif
+}
+
+int64_t current_bytes() {
+    return g_current_bytes.load(std::memory_order_relaxed);
+}
+
+int64_t peak_bytes() {
+    return g_peak_bytes.load(std::memory_order_relaxed);
+}
+
+void reset_peak() {
+    g_peak_bytes.store(g_current_bytes.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+}
+
+}  // namespace heap_usage
+
+void* operator new(std::size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, alignment);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     std::nothrow_t const&) noexcept {
+    return allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete(void* ptr, std::nothrow_t const&) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, std::nothrow_t const&) noexcept {
+    track_deallocation(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, std::nothrow_t const&) noexcept {
+    track_deallocation(ptr);
+}
@@ -1,8 +1,20 @@
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <random>
+#include <set>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -13,98 +25,1282 @@
 #include "../include/emphf_wrapper.hpp"
 #include "../include/emphf_hem_wrapper.hpp"
 #include "../include/fch.hpp"
+#include "../include/huge_page_allocator.hpp"
+#include "../include/key_arena.hpp"
+#include "../include/key_decompressor.hpp"
+#include "../include/key_file.hpp"
+#include "../include/key_pipeline.hpp"
+#include "../include/key_span.hpp"
+#include "../include/lookup_batch.hpp"
 #include "../include/pthash_wrapper.hpp"
 #ifndef __APPLE__
 #include "../include/recsplit_wrapper.hpp"
 #endif
 #include "../include/utils.hpp"
+#include "../include/benchmark_utils/baseline.hpp"
+#include "../include/benchmark_utils/cache_pressure.hpp"
+#include "../include/benchmark_utils/cycle_timer.hpp"
+#include "../include/benchmark_utils/latency_histogram.hpp"
+#include "../include/benchmark_utils/memory_tracker.hpp"
+#include "../include/benchmark_utils/numa.hpp"
+#include "../include/benchmark_utils/parameter_sweep.hpp"
+#include "../include/benchmark_utils/perf_counters.hpp"
+#include "../include/benchmark_utils/summary_statistics.hpp"
+#include "../include/benchmark_utils/tuning.hpp"
+#include "../include/serialization.hpp"
+#include "../include/benchmark_utils/query_workload.hpp"
+#include "../include/benchmark_utils/result_record.hpp"
 #include "../external/cmd_line_parser/include/parser.hpp"
 
 template <typename T>
-struct TestEnvironment {
-    TestEnvironment(std::vector<T>&& keys, uint32_t num_construction_runs = 1,
-                    uint32_t num_lookup_runs = 5, uint64_t seed = 0, bool verbose = false)
-        : keys(std::move(keys))
-        , num_construction_runs(num_construction_runs)
-        , num_lookup_runs(num_lookup_runs)
-        , seed(seed)
-        , verbose(verbose) {
-        if (num_construction_runs < 1) {
-            throw std::runtime_error("`num_construction_runs` must be strictly greater than zero");
+std::string key_type_name() {
+    if constexpr (std::is_same_v<T, std::string>) {
+        return "string";
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+        return "string_view";
+    } else {
+        return "uint" + std::to_string(8 * sizeof(T));
+    }
+}
+
+struct TestConfiguration {
+    uint32_t num_construction_runs = 1;
+    uint32_t num_lookup_runs = 5;
+    uint64_t seed = 0;
+    bool verbose = false;
+    std::string generator;  // description of the key source, reported with the results
+    unsigned num_threads = 1;
+    uint64_t num_latency_samples = 0;  // number of individually timed lookups (0 = disabled)
+    QueryWorkload workload;            // order of the keys looked up by the lookup test
+    unsigned max_lookup_threads = 0;   // max number of concurrent readers (0 = disabled)
+    std::vector<uint64_t> batch_sizes;  // sizes of the batches of the batched lookup test
+    bool perf_counters = false;         // read hardware counters during construction and lookup
+    bool track_memory = false;          // measure the peak memory of each construction run
+    uint32_t num_seeds = 1;             // number of seeds of the repeated construction test
+    CacheMode cache_mode = CacheMode::WARM;  // cache state of the lookups under cache pressure
+    uint64_t cache_scratch_bytes = 0;        // size of the buffer used to pollute the caches
+    uint64_t cache_batch_size = 1000;        // lookups between two evictions, in `cold` mode
+    uint64_t cache_lookups = 100000;         // lookups timed under cache pressure
+    std::string save_prefix;  // if not empty, the structures are saved to files with this prefix
+    std::string load_prefix;  // if not empty, the structures are loaded from files with this prefix
+    NumaMode numa_mode = NumaMode::NONE;  // placement of the copies looked up by the NUMA test
+    int numa_node = 0;                    // node of the copy in `bind` mode
+    unsigned numa_threads = 1;            // readers per node in the NUMA test
+    bool page_test = false;  // compare the lookups on copies backed by small and huge pages
+};
+
+/**
+ * Whether the arrays of the structure `MPHF` are allocated by `huge_page_allocator`, and thus
+ * follow the page mode when the structure is loaded
+ */
+template <typename MPHF>
+struct follows_page_mode : std::false_type {};
+
+template <typename Hasher>
+struct follows_page_mode<mphf::FCH<Hasher>> : std::true_type {};
+
+/**
+ * Keys of a test environment: in the `4k` page mode, kept in their vector or viewed where they are
+ * (e.g., in the mapping of a file of keys, which must then outlive the environment), and otherwise
+ * copied to an array allocated in the default page mode (see --huge_pages), so that the lookups
+ * read them from the same pages as the structures
+ */
+template <typename T>
+class OwnedKeys {
+public:
+    OwnedKeys() = default;
+
+    OwnedKeys(std::vector<T>&& keys) {
+        if (mphf::default_page_mode() == mphf::PageMode::SMALL || keys.empty()) {
+            m_keys = std::move(keys);
+            return;
+        }
+        m_paged_keys.assign(keys.begin(), keys.end());
+        std::vector<T>().swap(keys);
+    }
+
+    OwnedKeys(KeySpan<T> keys) {
+        if (mphf::default_page_mode() == mphf::PageMode::SMALL || keys.empty()) {
+            m_view = keys;
+            return;
         }
+        m_paged_keys.assign(keys.begin(), keys.end());
     }
 
+    KeySpan<T> span() const {
+        if (!m_view.empty()) return m_view;
+        return m_paged_keys.empty() ? KeySpan<T>(m_keys) : KeySpan<T>(m_paged_keys);
+    }
+
+private:
+    std::vector<T> m_keys;
+    mphf::huge_page_vector<T> m_paged_keys;
+    KeySpan<T> m_view;  // keys that are not owned
+};
+
+template <typename T>
+struct TestEnvironment {
+    TestEnvironment(OwnedKeys<T> keys, TestConfiguration const& config, ResultWriter& writer,
+                    OwnedKeys<T> negative_keys = {}, std::vector<uint64_t>&& key_hashes = {},
+                    double key_hashing_seconds = 0)
+        : m_keys(std::move(keys))
+        , m_negative_keys(std::move(negative_keys))
+        , m_key_hashes(std::move(key_hashes))
+        , keys(m_keys.span())
+        , negative_keys(m_negative_keys.span())
+        , key_hashes(m_key_hashes)
+        , key_hashing_seconds(key_hashing_seconds)
+        , num_construction_runs(config.num_construction_runs)
+        , num_lookup_runs(config.num_lookup_runs)
+        , seed(config.seed)
+        , verbose(config.verbose)
+        , config(config)
+        , writer(writer) {
+        init();
+    }
+
+    /**
+     * Environment of the first `num_keys` keys of `parent`, which are viewed without being copied,
+     * sharing its negative keys (but not the hashes of the keys, whose time is measured on all of
+     * them). It views the keys of `parent`, so it must not outlive it.
+     */
+    TestEnvironment(TestEnvironment const& parent, uint64_t num_keys,
+                    TestConfiguration const& config, ResultWriter& writer)
+        : keys(parent.keys.prefix(num_keys))
+        , negative_keys(parent.negative_keys)
+        , key_hashing_seconds(0)
+        , num_construction_runs(config.num_construction_runs)
+        , num_lookup_runs(config.num_lookup_runs)
+        , seed(config.seed)
+        , verbose(config.verbose)
+        , config(config)
+        , writer(writer) {
+        init();
+    }
+
+    // `keys` and the other views point into the keys owned by the environment (or by its parent),
+    // which a copy or a move would leave behind
+    TestEnvironment(TestEnvironment const&) = delete;
+    TestEnvironment(TestEnvironment&&) = delete;
+    TestEnvironment& operator=(TestEnvironment const&) = delete;
+    TestEnvironment& operator=(TestEnvironment&&) = delete;
+
+    /**
+     * Builds the structure with `builder` and runs the tests enabled by the configuration (or
+     * only the lookup tests on the saved structure, in lookup-only mode)
+     * @param construction_only Whether to run only the construction runs and the verification,
+     * skipping the lookup, save and seed tests (the structure is built even in lookup-only mode)
+     * @return The record of the results, also written by the result writer
+     */
     template <typename Builder>
-    void test(Builder const& builder) const {
+    ResultRecord test(Builder const& builder, bool construction_only = false) const {
         std::cerr << "Algorithm " << builder.name() << std::endl;
+        results.emplace_back();
+        results.back().add("algorithm", builder.name());  // tells the variant if the test fails
+
+        ResultRecord record;
+        record.add("algorithm", builder.name());
+        record.add("n", keys.size());
+        record.add("key_type", key_type_name<T>());
+        record.add("generator", config.generator);
+        record.add("seed", seed);
+        record.add("threads", builder.num_threads());
+        if (mphf::default_page_mode() != mphf::PageMode::SMALL) {
+            record.add("huge_pages", mphf::page_mode_name(mphf::default_page_mode()));
+        }
+        if (!config.load_prefix.empty() && !construction_only) {
+            test_saved(builder, record);
+            return record;
+        }
 
         Chrono chrono;
         TimeFormatter timeFormatter(2, true, true);
         uint64_t num_bits = 0;
+        std::vector<mphf::BuildStats> run_stats(num_construction_runs);
+        std::optional<PerfCounters> counters;
+        if (config.perf_counters) counters.emplace();
+        std::optional<MemoryTracker> memory;
+        if (config.track_memory) memory.emplace();
+        std::vector<uint64_t> peak_heap_bytes, peak_rss_bytes;
+        auto record_memory = [&]() {
+            memory->stop();
+            peak_heap_bytes.push_back(memory->peak_heap_bytes());
+            peak_rss_bytes.push_back(memory->peak_rss_bytes());
+        };
 
         // fit the mphf
+        if (memory) memory->start();
+        if (counters) counters->start();
         chrono.start();
-        auto mphf = builder.build(keys, seed, verbose);
+        auto mphf = builder.build(keys, seed, verbose, &run_stats[0]);
         chrono.stop();
+        if (counters) counters->stop();
+        if (memory) record_memory();
         num_bits = mphf.num_bits();
         for (uint32_t run = 1; run != num_construction_runs; ++run) {
+            if (memory) memory->start();
+            if (counters) counters->start();
             chrono.start();
-            builder.build(mphf, keys, seed, verbose);
+            builder.build(mphf, keys, seed, verbose, &run_stats[run]);
             chrono.stop();
+            if (counters) counters->stop();
+            if (memory) record_memory();
             num_bits += mphf.num_bits();
         }
-        double average_construction_time = chrono.average_time();
+        // the hashing of the keys done while reading them is part of the constructions using it
+        std::vector<double> construction_seconds = chrono.durations();
+        uint32_t num_prehashed_runs = 0;
+        for (uint32_t run = 0; run != num_construction_runs; ++run) {
+            if (run_stats[run].get("prehashed_fits") == 0) continue;
+            construction_seconds[run] += key_hashing_seconds;
+            ++num_prehashed_runs;
+        }
+        double average_construction_time =
+            std::accumulate(construction_seconds.begin(), construction_seconds.end(), 0.0) /
+            num_construction_runs;
         double space_usage = 1.0 * num_bits / (keys.size() * num_construction_runs);
         std::cerr << "Average Construction time: " << timeFormatter(average_construction_time);
         std::cerr << " (" << std::round(average_construction_time * 1000.0) / 1000.0 << "s)"
                   << std::endl;
+        if (num_prehashed_runs != 0) {
+            std::cerr << "Including the hashing of the keys while reading them: "
+                      << timeFormatter(key_hashing_seconds) << " of thread time" << std::endl;
+        }
         std::cerr << "Average Space usage: " << std::round(100.0 * space_usage) / 100.0
                   << " bits/key" << std::endl;
+        record.add("construction_runs", num_construction_runs);
+        record.add("construction_seconds", construction_seconds);
+        record.add("avg_construction_seconds", average_construction_time);
+        record.add("prehashed_keys", num_prehashed_runs != 0);
+        if (num_prehashed_runs != 0) record.add("key_hashing_seconds", key_hashing_seconds);
+        record.add("bits_per_key", space_usage);
+        report_build_stats(run_stats, record);
+        if (memory) {
+            uint64_t max_heap_bytes =
+                *std::max_element(peak_heap_bytes.begin(), peak_heap_bytes.end());
+            uint64_t max_rss_bytes =
+                *std::max_element(peak_rss_bytes.begin(), peak_rss_bytes.end());
+            double heap_per_key = 1.0 * max_heap_bytes / keys.size();
+            double rss_per_key = 1.0 * max_rss_bytes / keys.size();
+            std::cerr << "Peak construction memory: heap "
+                      << std::round(100.0 * heap_per_key) / 100.0 << " bytes/key, RSS "
+                      << std::round(100.0 * rss_per_key) / 100.0 << " bytes/key"
+                      << (memory->sampled() ? " (sampled)" : "") << std::endl;
+            if (mphf::default_page_mode() != mphf::PageMode::SMALL) {
+                // the arrays of at least 2 MiB are mapped, bypassing the heap tracking
+                std::cerr << "The heap usage excludes the arrays mapped in huge pages"
+                          << std::endl;
+                record.add("peak_heap_excludes_mapped_arrays", true);
+            }
+            record.add("construction_peak_heap_bytes", peak_heap_bytes);
+            record.add("construction_peak_rss_bytes", peak_rss_bytes);
+            record.add("peak_heap_bytes_per_key", heap_per_key);
+            record.add("peak_rss_bytes_per_key", rss_per_key);
+        }
+        if (counters) {
+            report_counters(*counters, "Construction", keys.size() * num_construction_runs,
+                            record, "construction");
+        }
+
+        if (construction_only) {
+            check(mphf, record);
+            std::cerr << std::endl;
+            write(record);
+            return record;
+        }
+
+        test_lookups(mphf, counters ? &*counters : nullptr, record);
+
+        // assess saving the structure and loading it back
+        if (!config.save_prefix.empty()) test_save_load(builder, mphf, record);
+
+        // assess the variability of construction and lookups over distinct seeds
+        if (config.num_seeds > 1) test_seeds(builder, record);
+        std::cerr << std::endl;
+
+        write(record);
+        return record;
+    }
+
+private:
+    const OwnedKeys<T> m_keys, m_negative_keys;  // empty for a prefix environment
+    const std::vector<uint64_t> m_key_hashes;
+
+public:
+    const KeySpan<T> keys;
+    const KeySpan<T> negative_keys;  // keys not in `keys`, queried in a separate test
+    // hashes of `keys` for FCH with `seed`, computed while reading them (empty if not computed),
+    // and the thread time spent computing them, added to the constructions that use them
+    const KeySpan<uint64_t> key_hashes;
+    const double key_hashing_seconds;
+    const uint32_t num_construction_runs, num_lookup_runs;
+    const uint64_t seed;
+    const bool verbose;
+    const TestConfiguration config;
+    // results of the tests run so far, one per call of `test` (with only the algorithm if the test
+    // did not complete)
+    mutable std::vector<ResultRecord> results;
 
-        // check the construction (this operation also warms-up the cache)
+private:
+    /**
+     * Checks the configuration and creates the query sequence
+     */
+    void init() {
+        if (num_construction_runs < 1) {
+            throw std::runtime_error("`num_construction_runs` must be strictly greater than zero");
+        }
+        if (config.num_latency_samples != 0 || config.cache_mode != CacheMode::WARM ||
+            !config.save_prefix.empty()) {
+            timer.calibrate();
+        }
+        if (config.perf_counters && !PerfCounters().any_available()) {
+            std::cerr << "Warning: hardware performance counters are unavailable (check "
+                         "/proc/sys/kernel/perf_event_paranoid), they will be reported as n/a"
+                      << std::endl;
+        }
+        queries = create_queries(keys, config.workload, seed, num_missing_queries);
+        if (config.workload.distribution != QueryDistribution::SEQUENTIAL) {
+            std::cerr << "Query workload: " << config.workload.name() << ", " << queries.size()
+                      << " queries";
+            if (num_missing_queries != 0) {
+                std::cerr << " (" << num_missing_queries << " trace entries not in the set)";
+            }
+            std::cerr << std::endl << std::endl;
+        }
+    }
+
+    /**
+     * Checks that `mphf` maps the keys to distinct positions in [0, n)
+     * @return "ok", "out_of_range" or "duplicates"
+     */
+    template <typename MPHF>
+    std::string verify(MPHF const& mphf) const {
         const __uint128_t num_keys = keys.size();
         __uint128_t sum = 0;
         for (const T& key : keys) {
             uint64_t pos = mphf(key);
-            if (pos >= num_keys) { throw std::runtime_error("MPHF contains out of range values"); }
+            if (pos >= num_keys) return "out_of_range";
             sum += pos;
         }
-        if (sum != (num_keys - 1) * (num_keys) / 2) {
+        if (sum != (num_keys - 1) * (num_keys) / 2) return "duplicates";
+        return "ok";
+    }
+
+    /**
+     * Verifies `mphf`, adding the outcome to `record`
+     * @throws std::runtime_error if the verification fails
+     */
+    template <typename MPHF>
+    void check(MPHF const& mphf, ResultRecord& record) const {
+        std::string verification = verify(mphf);
+        record.add("verification", verification);
+        if (verification == "out_of_range") {
+            report_failure(record);
+            throw std::runtime_error("MPHF contains out of range values");
+        }
+        if (verification == "duplicates") {
+            report_failure(record);
             throw std::runtime_error("MPHF contains duplicates");
         }
+    }
+
+    /**
+     * Verifies `mphf` and runs the lookup tests enabled by the configuration, adding their results
+     * to `record`. The lookup counters are read with `counters`, if not null.
+     */
+    template <typename MPHF>
+    void test_lookups(MPHF const& mphf, PerfCounters* counters, ResultRecord& record) const {
+        TimeFormatter timeFormatter(2, true, true);
+
+        // check the structure (this operation also warms-up the cache)
+        check(mphf, record);
 
         // assess the random access lookup time
+        double average_lookup_time = std::nan("");
         if (num_lookup_runs != 0) {
+            if (counters) {
+                counters->reset();
+                counters->start();
+            }
+            average_lookup_time = measure_lookup_time(mphf, keys, queries);
+            if (counters) counters->stop();
+            std::cerr << "Average Lookup time: " << timeFormatter(average_lookup_time) << std::endl;
+            if (counters) {
+                uint64_t num_queries = queries.empty() ? keys.size() : queries.size();
+                report_counters(*counters, "Lookup", num_queries * num_lookup_runs, record,
+                                "lookup");
+            }
+        }
+        record.add("query_distribution", config.workload.name());
+        record.add("num_queries", queries.empty() ? keys.size() : queries.size());
+        if (config.workload.distribution == QueryDistribution::TRACE) {
+            record.add("trace_missing_queries", num_missing_queries);
+        }
+        record.add("lookup_runs", num_lookup_runs);
+        record.add("lookup_ns_per_key", average_lookup_time * 1e9);
+
+        // assess the latency distribution of single lookups
+        if (config.num_latency_samples != 0) {
+            LatencyHistogram histogram =
+                sample_latencies(mphf, keys, queries, config.num_latency_samples);
+            histogram.print(std::cerr, "Lookup latency");
+            record.add("latency_timer", CycleTimer::name());
+            record.add("latency_timer_overhead_ns", timer.overhead_ns());
+            histogram.report(record, "latency");
+        }
+
+        // assess the lookup latency when the structure competes for the caches
+        if (config.cache_mode != CacheMode::WARM) test_cache_pressure(mphf, record);
+
+        // assess the lookup throughput of concurrent readers sharing the same structure
+        if (config.max_lookup_threads != 0 && num_lookup_runs != 0) {
+            std::vector<uint64_t> threads_series;
+            std::vector<double> throughputs, latencies;
+            for (unsigned num_threads = 1; true; num_threads *= 2) {
+                num_threads = std::min(num_threads, config.max_lookup_threads);
+                auto [throughput, latency] = measure_parallel_lookups(mphf, num_threads);
+                threads_series.push_back(num_threads);
+                throughputs.push_back(throughput / 1e6);
+                latencies.push_back(latency * 1e9);
+                std::cerr << "Parallel Lookups with " << num_threads << " threads: "
+                          << std::round(throughputs.back() * 100) / 100 << " Mlookups/s ("
+                          << std::round(100 * throughputs.back() / throughputs.front()) / 100
+                          << "x), " << timeFormatter(latency) << " per lookup per thread"
+                          << std::endl;
+                if (num_threads == config.max_lookup_threads) break;
+            }
+            record.add("parallel_lookup_threads", threads_series);
+            record.add("parallel_lookup_mlookups_per_sec", throughputs);
+            record.add("parallel_lookup_ns_per_key", latencies);
+        }
+
+        // assess the lookup throughput of readers pinned to each NUMA node
+        if (config.numa_mode != NumaMode::NONE && num_lookup_runs != 0) test_numa(mphf, record);
+
+        // assess the lookup time depending on the size of the pages backing the structure
+        if (config.page_test && num_lookup_runs != 0) test_page_sizes(mphf, record);
+
+        // assess the lookup time of batches of keys, compared to single-key lookups
+        if (!config.batch_sizes.empty() && num_lookup_runs != 0) {
+            double scalar_time = measure_batch_lookup_time(mphf, 0);
+            std::cerr << "Batched Lookup time: scalar " << timeFormatter(scalar_time);
+            std::vector<double> batch_times;
+            for (uint64_t batch_size : config.batch_sizes) {
+                batch_times.push_back(measure_batch_lookup_time(mphf, batch_size));
+                std::cerr << ", batch_size=" << batch_size << " "
+                          << timeFormatter(batch_times.back()) << " ("
+                          << std::round(100 * scalar_time / batch_times.back()) / 100 << "x)";
+                batch_times.back() *= 1e9;
+            }
+            std::cerr << std::endl;
+            record.add("batch_scalar_ns_per_key", scalar_time * 1e9);
+            record.add("batch_sizes", config.batch_sizes);
+            record.add("batch_lookup_ns_per_key", batch_times);
+        }
+
+        // assess the lookup time of keys that do not belong to the set
+        if (!negative_keys.empty()) {
+            record.add("negative_n", negative_keys.size());
+            double average_negative_lookup_time = std::nan("");
+            if (num_lookup_runs != 0) {
+                average_negative_lookup_time = measure_lookup_time(mphf, negative_keys, {});
+                std::cerr << "Average Negative Lookup time: "
+                          << timeFormatter(average_negative_lookup_time) << std::endl;
+            }
+            record.add("negative_lookup_ns_per_key", average_negative_lookup_time * 1e9);
+            if (config.num_latency_samples != 0) {
+                LatencyHistogram histogram =
+                    sample_latencies(mphf, negative_keys, {}, config.num_latency_samples);
+                histogram.print(std::cerr, "Negative lookup latency");
+                histogram.report(record, "negative_latency");
+            }
+        }
+    }
+
+    /**
+     * Loads the structure that `builder` saved to `<load_prefix><algorithm>.mphf`, by
+     * memory-mapping the file, and runs only the verification and the lookup tests on it. The
+     * structures that support it (FCH) are used in place from the mapping.
+     */
+    template <typename Builder>
+    void test_saved(Builder const& builder, ResultRecord& record) const {
+        using MPHF = decltype(builder.build(keys));
+        std::string filename = config.load_prefix + file_name(builder.name()) + ".mphf";
+        if (!std::ifstream(filename, std::ios::binary)) {
+            std::cerr << "Skipped: `" << filename << "` not found" << std::endl << std::endl;
+            return;
+        }
+
+        Chrono chrono;
+        chrono.start();
+        mphf::mapped_file mapping(filename);
+        MPHF mphf;
+        load_saved(mphf, builder.name(), filename, &mapping);
+        chrono.stop();
+        double space_usage = 1.0 * mphf.num_bits() / keys.size();
+        std::cerr << "Loaded from " << filename << " ("
+                  << (mphf::has_map<MPHF>::value ? "zero-copy" : "deserialized") << ") in "
+                  << TimeFormatter::format(chrono.elapsed_time()) << std::endl;
+        std::cerr << "Space usage: " << std::round(100.0 * space_usage) / 100.0 << " bits/key"
+                  << std::endl;
+        record.add("load_filename", filename);
+        record.add("load_bytes", mapping.size());
+        record.add("load_seconds", chrono.elapsed_time());
+        record.add("load_zero_copy", mphf::has_map<MPHF>::value);
+        record.add("bits_per_key", space_usage);
+
+        std::optional<PerfCounters> counters;
+        if (config.perf_counters) counters.emplace();
+        test_lookups(mphf, counters ? &*counters : nullptr, record);
+        std::cerr << std::endl;
+
+        write(record);
+    }
+
+    /**
+     * Adds to `record` the time spent in each construction phase in each run, and the events
+     * counted by the builder over all the runs
+     */
+    void report_build_stats(std::vector<mphf::BuildStats> const& run_stats,
+                            ResultRecord& record) const {
+        mphf::BuildStats total;
+        for (auto const& stats : run_stats) total.merge(stats);
+        if (!total.phases().empty()) {
+            double total_seconds = 0;
+            for (auto const& phase : total.phases()) total_seconds += phase.second;
+            std::cerr << "Construction phases:";
+            for (auto const& [phase, seconds] : total.phases()) {
+                double average_seconds = seconds / run_stats.size();
+                std::vector<double> run_seconds;
+                for (auto const& stats : run_stats) {
+                    double phase_seconds = 0;
+                    for (auto const& [name, s] : stats.phases()) {
+                        if (name == phase) phase_seconds = s;
+                    }
+                    run_seconds.push_back(phase_seconds);
+                }
+                record.add("construction_phase_" + phase + "_seconds", run_seconds);
+                std::cerr << " " << phase << " "
+                          << (average_seconds > 0 ? TimeFormatter::format(average_seconds, 1)
+                                                  : "0s");
+                if (total_seconds > 0) {
+                    std::cerr << " (" << std::round(1000 * seconds / total_seconds) / 10 << "%)";
+                }
+            }
+            std::cerr << std::endl;
+        }
+        for (auto const& [event, amount] : total.counts()) {
+            std::cerr << "Construction " << event << ": " << amount << std::endl;
+            record.add("construction_" + event, amount);
+        }
+    }
+
+    /**
+     * Builds and queries the structure with the seeds `seed`, `seed + 1`, ...,
+     * `seed + num_seeds - 1`, and adds to `record` the summary statistics of the construction
+     * time, space and lookup time, along with the number of failed constructions and the events
+     * counted by the builder (e.g., restarts) over all the seeds
+     */
+    template <typename Builder>
+    void test_seeds(Builder const& builder, ResultRecord& record) const {
+        if (!builder.seeded()) {
+            std::cerr << "Seeds: skipped, the structure does not depend on the seed" << std::endl;
+            record.add("seeds_skipped", "the structure does not depend on the seed");
+            return;
+        }
+        std::vector<uint64_t> seeds;
+        std::vector<double> construction_times, bits_per_key, lookup_times;
+        uint64_t num_failures = 0;
+        mphf::BuildStats build_stats;
+        for (uint32_t i = 0; i != config.num_seeds; ++i) {
+            uint64_t run_seed = seed + i;
+            seeds.push_back(run_seed);
+            Chrono chrono;
+            mphf::BuildStats seed_stats;
+            try {
+                chrono.start();
+                auto mphf = builder.build(keys, run_seed, verbose, &seed_stats);
+                chrono.stop();
+                std::string verification = verify(mphf);
+                if (verification != "ok") {
+                    throw std::runtime_error("verification failed (" + verification + ")");
+                }
+                const bool prehashed = seed_stats.get("prehashed_fits") != 0;
+                construction_times.push_back(chrono.elapsed_time() +
+                                             (prehashed ? key_hashing_seconds : 0));
+                bits_per_key.push_back(1.0 * mphf.num_bits() / keys.size());
+                if (num_lookup_runs != 0) {
+                    lookup_times.push_back(measure_lookup_time(mphf, keys, queries) * 1e9);
+                }
+            } catch (std::runtime_error const& e) {
+                std::cerr << "Construction with seed " << run_seed << " failed: " << e.what()
+                          << std::endl;
+                ++num_failures;
+            }
+            build_stats.merge(seed_stats);
+        }
+
+        std::cerr << "Seeds: " << config.num_seeds << " (" << num_failures
+                  << " failed constructions)" << std::endl;
+        record.add("seeds", seeds);
+        record.add("seeds_construction_failures", num_failures);
+        for (auto const& [event, amount] : build_stats.counts()) {
+            std::cerr << "Seeds " << event << ": " << amount << std::endl;
+            record.add("seeds_construction_" + event, amount);
+        }
+        SummaryStatistics construction(construction_times);
+        construction.print(std::cerr, "Construction time over seeds", "s");
+        construction.report(record, "seeds_construction_seconds");
+        SummaryStatistics space(bits_per_key);
+        space.print(std::cerr, "Space usage over seeds", " bits/key");
+        space.report(record, "seeds_bits_per_key");
+        if (num_lookup_runs != 0) {
+            SummaryStatistics lookup(lookup_times);
+            lookup.print(std::cerr, "Lookup time over seeds", "ns");
+            lookup.report(record, "seeds_lookup_ns_per_key");
+        }
+    }
+
+    /**
+     * @return The average time in seconds to look up a key, over `num_lookup_runs` scans of the
+     * keys of `source` at `positions` (or of all the keys of `source`, in order, if empty)
+     */
+    template <typename MPHF, typename Keys>
+    double measure_lookup_time(MPHF& mphf, Keys const& source, KeySpan<uint64_t> positions) const {
+        Chrono chrono;
+        chrono.start();
+        for (uint64_t run = 0; run != num_lookup_runs; ++run) {
+            if (positions.empty()) {
+                for (const T& key : source) { do_not_optimize_away(mphf(key)); }
+            } else {
+                for (uint64_t pos : positions) { do_not_optimize_away(mphf(source[pos])); }
+            }
+        }
+        chrono.stop();
+        uint64_t num_queries = positions.empty() ? source.size() : positions.size();
+        return chrono.elapsed_time() / (num_queries * num_lookup_runs);
+    }
+
+    /**
+     * @return The average time in seconds to look up a key of the query sequence, when the keys
+     * are passed to `mphf::lookup_batch` in batches of `batch_size` keys (0 = one key at a time to
+     * `operator()`). The positions are summed so that no lookup can be optimized away.
+     */
+    template <typename MPHF>
+    double measure_batch_lookup_time(MPHF const& mphf, uint64_t batch_size) const {
+        const uint64_t num_queries = queries.empty() ? keys.size() : queries.size();
+        std::vector<uint64_t> positions(std::max<uint64_t>(batch_size, 1));
+        uint64_t checksum = 0;
+
+        auto run = [&](auto begin, uint64_t size) {
+            if (batch_size == 0) {
+                for (uint64_t i = 0; i != size; ++i, ++begin) { checksum += mphf(*begin); }
+                return;
+            }
+            for (uint64_t i = 0; i < size; i += batch_size) {
+                uint64_t current_batch_size = std::min(batch_size, size - i);
+                auto end = begin;
+                std::advance(end, current_batch_size);
+                mphf::lookup_batch(mphf, begin, end, positions.begin());
+                for (uint64_t j = 0; j != current_batch_size; ++j) { checksum += positions[j]; }
+                begin = end;
+            }
+        };
+
+        Chrono chrono;
+        chrono.start();
+        for (uint64_t r = 0; r != num_lookup_runs; ++r) {
+            if (queries.empty()) {
+                run(keys.begin(), num_queries);
+            } else {
+                run(IndirectIterator<T>(keys.data(), queries.data()), num_queries);
+            }
+        }
+        chrono.stop();
+        do_not_optimize_away(checksum);
+        return chrono.elapsed_time() / (num_queries * num_lookup_runs);
+    }
+
+    /**
+     * Runs `num_threads` readers that concurrently perform `num_lookup_runs` scans of the query
+     * sequence, each one starting from a different offset.
+     * @return The aggregated throughput in lookups per second, and the average time in seconds
+     * spent by a reader for a lookup
+     */
+    template <typename MPHF>
+    std::pair<double, double> measure_parallel_lookups(MPHF const& mphf,
+                                                       unsigned num_threads) const {
+        std::vector<Reader<MPHF>> readers(num_threads, {&mphf, keys, queries, -1});
+        return measure_readers(readers, {});
+    }
+
+    /**
+     * A reader of the parallel lookup test: the structure, the copies of the keys and of the query
+     * sequence it looks up, and the NUMA node whose CPUs run it (-1 = any CPU)
+     */
+    template <typename MPHF>
+    struct Reader {
+        MPHF const* mphf;
+        KeySpan<T> keys;
+        KeySpan<uint64_t> queries;
+        int node;
+    };
+
+    /**
+     * Runs the `readers` concurrently, as `measure_parallel_lookups(mphf, num_threads)`, pinning
+     * each one to the CPUs of its node in `node_cpus`
+     */
+    template <typename MPHF>
+    std::pair<double, double> measure_readers(
+        std::vector<Reader<MPHF>> const& readers,
+        std::vector<std::vector<int>> const& node_cpus) const {
+        const unsigned num_threads = readers.size();
+        const uint64_t num_queries = queries.empty() ? keys.size() : queries.size();
+        const uint64_t num_lookups = num_queries * num_lookup_runs;
+        std::vector<double> elapsed(num_threads);
+        std::atomic<unsigned> num_ready(0);
+        std::atomic<bool> go(false);
+
+        auto reader = [&](unsigned thread_id) {
+            uint64_t offset = num_queries / num_threads * thread_id;
+            MPHF const& mphf = *readers[thread_id].mphf;
+            KeySpan<T> keys = readers[thread_id].keys;
+            KeySpan<uint64_t> queries = readers[thread_id].queries;
+            int node = readers[thread_id].node;
+            if (node >= 0) pin_current_thread(node_cpus[node]);
+            num_ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {}
+            Chrono chrono;
+            chrono.start();
+            for (uint64_t i = 0, j = offset; i != num_lookups; ++i, ++j) {
+                if (j == num_queries) j = 0;
+                do_not_optimize_away(mphf(queries.empty() ? keys[j] : keys[queries[j]]));
+            }
+            chrono.stop();
+            elapsed[thread_id] = chrono.elapsed_time();
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (unsigned t = 0; t != num_threads; ++t) { threads.emplace_back(reader, t); }
+        while (num_ready.load() != num_threads) {}
+        Chrono chrono;
+        chrono.start();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) { thread.join(); }
+        chrono.stop();
+
+        double average_elapsed =
+            std::accumulate(elapsed.begin(), elapsed.end(), 0.0) / num_threads;
+        return {num_lookups * num_threads / chrono.elapsed_time(), average_elapsed / num_lookups};
+    }
+
+    /**
+     * Times `num_samples` single lookups of the keys of `source` at `positions`, cycling over
+     * them, or of keys drawn uniformly at random from `source` if `positions` is empty.
+     * Each measurement is net of the overhead of the timer.
+     */
+    template <typename MPHF>
+    LatencyHistogram sample_latencies(MPHF& mphf, KeySpan<T> source, KeySpan<uint64_t> positions,
+                                      uint64_t num_samples, CacheEvictor* evictor = nullptr,
+                                      uint64_t eviction_interval = 0) const {
+        LatencyHistogram histogram;
+        histogram.reserve(num_samples);
+        std::mt19937_64 generator(seed);
+        std::uniform_int_distribution<uint64_t> distribution(0, source.size() - 1);
+        for (uint64_t i = 0; i != num_samples; ++i) {
+            if (evictor && i % eviction_interval == 0) evictor->evict();
+            const T& key = positions.empty() ? source[distribution(generator)]
+                                             : source[positions[i % positions.size()]];
+            uint64_t t0 = CycleTimer::start();
+            uint64_t pos = mphf(key);
+            do_not_optimize_away(pos);
+            uint64_t t1 = CycleTimer::stop();
+            histogram.add(timer.elapsed_ns(t0, t1));
+        }
+        return histogram;
+    }
+
+    /**
+     * Times single lookups while the caches are flushed every `cache_batch_size` lookups (`cold`
+     * mode) or while a concurrent thread streams over memory (`antagonist` mode), which also
+     * measures the average lookup time of the lookup test
+     */
+    template <typename MPHF>
+    void test_cache_pressure(MPHF& mphf, ResultRecord& record) const {
+        std::string mode = cache_mode_name(config.cache_mode);
+        record.add("cache_mode", mode);
+        record.add("cache_scratch_bytes", config.cache_scratch_bytes);
+        LatencyHistogram histogram;
+        if (config.cache_mode == CacheMode::COLD) {
+            CacheEvictor evictor(config.cache_scratch_bytes);
+            histogram = sample_latencies(mphf, keys, queries, config.cache_lookups, &evictor,
+                                         config.cache_batch_size);
+            record.add("cache_batch_size", config.cache_batch_size);
+        } else {
+            BandwidthAntagonist antagonist(config.cache_scratch_bytes);
+            if (num_lookup_runs != 0) {
+                double average_lookup_time = measure_lookup_time(mphf, keys, queries);
+                std::cerr << "Average Lookup time (antagonist): "
+                          << TimeFormatter::format(average_lookup_time) << std::endl;
+                record.add("cache_lookup_ns_per_key", average_lookup_time * 1e9);
+            }
+            histogram = sample_latencies(mphf, keys, queries, config.cache_lookups);
+            record.add("cache_antagonist_passes", antagonist.passes());
+        }
+        histogram.print(std::cerr, "Lookup latency (" + mode + " cache)");
+        histogram.report(record, "cache_latency");
+    }
+
+    /**
+     * Saves `mphf` to `<save_prefix><algorithm>.mphf`, then loads it back both by reading the file
+     * into memory and by memory-mapping it, after evicting the file from the page cache, and
+     * measures the load time and the latency of the first lookup. The structures that support it
+     * (FCH) are used in place from the mapping, while the others are deserialized from it.
+     */
+    template <typename Builder, typename MPHF>
+    void test_save_load(Builder const& builder, MPHF const& mphf, ResultRecord& record) const {
+        std::string filename = config.save_prefix + file_name(builder.name()) + ".mphf";
+        mphf::file_header header{builder.name(), key_type_name<T>(), keys.size()};
+        Chrono chrono;
+        chrono.start();
+        {
+            std::ofstream os(filename, std::ios::binary);
+            if (!os) throw std::runtime_error("Unable to create `" + filename + "`");
+            header.save(os);
+            mphf.save(os);
+            os.close();
+            if (!os) throw std::runtime_error("Error while writing `" + filename + "`");
+        }
+        chrono.stop();
+        uint64_t num_bytes = std::ifstream(filename, std::ios::binary | std::ios::ate).tellg();
+        std::cerr << "Saved to " << filename << ": " << num_bytes << " bytes in "
+                  << TimeFormatter::format(chrono.elapsed_time()) << std::endl;
+        record.add("save_filename", filename);
+        record.add("save_bytes", num_bytes);
+        record.add("save_seconds", chrono.elapsed_time());
+
+        for (bool use_mmap : {false, true}) {
+            std::string mode = use_mmap ? "mmap" : "read";
+            mphf::evict_file_pages(filename);
+            std::unique_ptr<mphf::mapped_file> mapping;
+            MPHF loaded;
             chrono.reset_and_start();
-            for (uint64_t run = 0; run != num_lookup_runs; ++run) {
-                for (const T& key : keys) { do_not_optimize_away(mphf(key)); }
+            if (use_mmap) {
+                mapping = std::make_unique<mphf::mapped_file>(filename);
+                load_saved(loaded, builder.name(), filename, &*mapping);
+            } else {
+                load_saved(loaded, builder.name(), filename, nullptr);
             }
             chrono.stop();
-            double average_lookup_time = chrono.elapsed_time() / (keys.size() * num_lookup_runs);
-            std::cerr << "Average Lookup time: " << timeFormatter(average_lookup_time) << std::endl;
+            uint64_t t0 = CycleTimer::start();
+            uint64_t pos = loaded(keys.front());
+            do_not_optimize_away(pos);
+            uint64_t t1 = CycleTimer::stop();
+            double first_lookup_ns = timer.elapsed_ns(t0, t1);
+            std::string verification = verify(loaded);
+            if (verification != "ok") {
+                throw std::runtime_error("The loaded structure fails the verification (" +
+                                         verification + ")");
+            }
+            std::cerr << "Load (" << mode
+                      << (use_mmap && mphf::has_map<MPHF>::value ? ", zero-copy" : "")
+                      << "): " << TimeFormatter::format(chrono.elapsed_time())
+                      << ", first lookup " << TimeFormatter::format(first_lookup_ns / 1e9)
+                      << std::endl;
+            record.add("load_" + mode + "_seconds", chrono.elapsed_time());
+            record.add("load_" + mode + "_first_lookup_ns", first_lookup_ns);
+        }
+        record.add("load_mmap_zero_copy", mphf::has_map<MPHF>::value);
+    }
+
+    /**
+     * Loads into `mphf` the structure saved in `filename` by `test_save_load`, from `mapping` if
+     * not null, checking that it was built by `algorithm` on the same type and number of keys
+     */
+    template <typename MPHF>
+    void load_saved(MPHF& mphf, std::string const& algorithm, std::string const& filename,
+                    mphf::mapped_file const* mapping) const {
+        std::unique_ptr<std::istream> is;
+        std::unique_ptr<mphf::memory_streambuf> buffer;
+        if (mapping) {
+            buffer = std::make_unique<mphf::memory_streambuf>(mapping->data(),
+                                                              mapping->data() + mapping->size());
+            is = std::make_unique<std::istream>(buffer.get());
+        } else {
+            is = std::make_unique<std::ifstream>(filename, std::ios::binary);
+            if (!*is) throw std::runtime_error("Unable to open `" + filename + "`");
+        }
+        mphf::file_header header;
+        header.load(*is);
+        if (header.algorithm != algorithm) {
+            throw std::runtime_error("`" + filename + "` contains a structure built by " +
+                                     header.algorithm + ", not by " + algorithm);
+        }
+        if (header.key_type != key_type_name<T>() || header.num_keys != keys.size()) {
+            throw std::runtime_error("`" + filename + "` contains a structure built on " +
+                                     std::to_string(header.num_keys) + " keys of type " +
+                                     header.key_type);
+        }
+        if constexpr (mphf::has_map<MPHF>::value) {
+            if (mapping) {
+                mphf.map(mapping->data() + is->tellg(), mapping->data() + mapping->size());
+                return;
+            }
+        }
+        mphf.load(*is);
+    }
+
+    /**
+     * @return `name` with the characters that are not letters, digits, dots or dashes replaced by
+     * underscores, without repeated underscores
+     */
+    static std::string file_name(std::string const& name) {
+        std::string result;
+        for (char c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') c = '_';
+            if (c != '_' || (!result.empty() && result.back() != '_')) result.push_back(c);
+        }
+        while (!result.empty() && result.back() == '_') result.pop_back();
+        return result;
+    }
+
+    /**
+     * A copy of the structure, of the keys and of the query sequence, placed in memory by a memory
+     * policy. The keys and the queries are in fresh mappings, so that the policy places all their
+     * pages; the structure is allocated by its library, which may reuse pages placed before.
+     */
+    template <typename MPHF>
+    struct Replica {
+        MPHF mphf;
+        MappedVector<T> keys;
+        MappedVector<char> key_bytes;  // characters of the `std::string_view` keys
+        MappedVector<uint64_t> queries;
+        bool placed;  // whether the memory policy was applied
+    };
+
+    /**
+     * @return A copy of `mphf` (through a serialization round trip), of the keys (with their
+     * characters, for `std::string_view` keys) and of the query sequence, allocated and filled
+     * under the memory policy `policy` over `nodes`
+     */
+    template <typename MPHF>
+    std::unique_ptr<Replica<MPHF>> place(MPHF const& mphf, ScopedMemoryPolicy::Policy policy,
+                                         std::vector<int> const& nodes) const {
+        std::stringstream buffer;
+        mphf.save(buffer);
+        ScopedMemoryPolicy scoped_policy(policy, nodes);
+        auto replica = std::make_unique<Replica<MPHF>>();
+        replica->mphf.load(buffer);
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            // copying the views alone would leave the characters where they are
+            uint64_t num_bytes = 0;
+            for (std::string_view key : keys) num_bytes += key.size();
+            replica->key_bytes.resize(num_bytes);
+            replica->keys.reserve(keys.size());
+            char* bytes = replica->key_bytes.data();
+            for (std::string_view key : keys) {
+                std::copy(key.begin(), key.end(), bytes);
+                replica->keys.emplace_back(bytes, key.size());
+                bytes += key.size();
+            }
+        } else {
+            replica->keys.assign(keys.begin(), keys.end());
+        }
+        replica->queries.assign(queries.begin(), queries.end());
+        replica->placed = scoped_policy.applied();
+        return replica;
+    }
+
+    /**
+     * Measures the lookup throughput of `config.numa_threads` readers per NUMA node, each pinned to
+     * the CPUs of its node, depending on the placement of the structure and of the keys:
+     * - `bind`: a copy on `config.numa_node`, looked up from each node in turn, so as to compare
+     *   local and remote lookups;
+     * - `interleave`: a copy interleaved over all the nodes, looked up from each node in turn;
+     * - `replicate`: the readers of all the nodes run concurrently, first sharing the copy on
+     *   `config.numa_node`, then each one looking up the copy on its own node.
+     */
+    template <typename MPHF>
+    void test_numa(MPHF const& mphf, ResultRecord& record) const {
+        const auto node_cpus = numa_node_cpus();
+        const std::vector<int> nodes = numa_nodes_with_cpus(node_cpus);
+        const int num_nodes = nodes.size();
+        auto readers_of = [&](Replica<MPHF> const& replica, int node) {
+            return std::vector<Reader<MPHF>>(config.numa_threads,
+                                             {&replica.mphf, replica.keys, replica.queries, node});
+        };
+        record.add("numa_mode", numa_mode_name(config.numa_mode));
+        record.add("numa_nodes", num_nodes);
+        record.add("numa_node_ids", nodes);
+        record.add("numa_threads_per_node", config.numa_threads);
+
+        if (config.numa_mode == NumaMode::REPLICATE) {
+            std::map<int, std::unique_ptr<Replica<MPHF>>> replicas;
+            bool placed = true;
+            for (int node : nodes) {
+                replicas[node] = place(mphf, ScopedMemoryPolicy::BIND, {node});
+                placed &= replicas[node]->placed;
+            }
+            std::vector<Reader<MPHF>> shared, replicated;
+            for (int node : nodes) {
+                auto readers = readers_of(*replicas[config.numa_node], node);
+                shared.insert(shared.end(), readers.begin(), readers.end());
+                readers = readers_of(*replicas[node], node);
+                replicated.insert(replicated.end(), readers.begin(), readers.end());
+            }
+            double shared_throughput = measure_readers(shared, node_cpus).first / 1e6;
+            double replicated_throughput = measure_readers(replicated, node_cpus).first / 1e6;
+            std::cerr << "NUMA lookups from " << num_nodes << " nodes: shared copy on node "
+                      << config.numa_node << " " << std::round(shared_throughput * 100) / 100
+                      << " Mlookups/s, one copy per node "
+                      << std::round(replicated_throughput * 100) / 100 << " Mlookups/s ("
+                      << std::round(100 * replicated_throughput / shared_throughput) / 100 << "x)"
+                      << (placed ? "" : " (memory policy not applied)") << std::endl;
+            record.add("numa_placed", placed);
+            record.add("numa_shared_mlookups_per_sec", shared_throughput);
+            record.add("numa_replicated_mlookups_per_sec", replicated_throughput);
+            return;
+        }
+
+        const bool bind = config.numa_mode == NumaMode::BIND;
+        auto replica = bind ? place(mphf, ScopedMemoryPolicy::BIND, {config.numa_node})
+                            : place(mphf, ScopedMemoryPolicy::INTERLEAVE, nodes);
+        std::vector<double> throughputs;
+        double local_throughput = 0, remote_throughput = 0;
+        std::cerr << "NUMA lookups (" << (bind ? "bound to node " + std::to_string(config.numa_node)
+                                               : std::string("interleaved"))
+                  << (replica->placed ? "" : ", memory policy not applied") << "):";
+        for (int node : nodes) {
+            auto [throughput, latency] = measure_readers(readers_of(*replica, node), node_cpus);
+            throughputs.push_back(throughput / 1e6);
+            if (node == config.numa_node) {
+                local_throughput = throughputs.back();
+            } else {
+                remote_throughput += throughputs.back() / (num_nodes - 1);
+            }
+            std::cerr << " node " << node
+                      << (bind ? (node == config.numa_node ? " (local) " : " (remote) ") : " ")
+                      << std::round(throughputs.back() * 100) / 100 << " Mlookups/s";
         }
         std::cerr << std::endl;
+        record.add("numa_placed", replica->placed);
+        record.add("numa_node_mlookups_per_sec", throughputs);
+        if (bind) {
+            record.add("numa_bound_node", config.numa_node);
+            record.add("numa_local_mlookups_per_sec", local_throughput);
+            record.add("numa_remote_mlookups_per_sec",
+                       num_nodes > 1 ? remote_throughput : std::nan(""));
+        }
     }
 
-    const std::vector<T> keys;
-    const uint32_t num_construction_runs, num_lookup_runs;
-    const uint64_t seed;
-    const bool verbose;
+    /**
+     * Measures the lookup time of copies of `mphf` (through a serialization round trip), of the
+     * keys and of the query sequence allocated in each page mode: `4k`, `thp` and `2m`. Only the
+     * arrays allocated by `huge_page_allocator` follow the page mode; RecSplit keeps the allocation
+     * type it was built with (see --huge_pages), and the other libraries use the global allocator.
+     * For them, only the pages of the keys and queries change, which the record tells by
+     * `page_test_arrays`.
+     */
+    template <typename MPHF>
+    void test_page_sizes(MPHF const& mphf, ResultRecord& record) const {
+        TimeFormatter timeFormatter(2, true, true);
+        std::stringstream buffer;
+        mphf.save(buffer);
+        const uint64_t fallbacks = mphf::huge_page_fallbacks();
+        constexpr bool structure_pages = follows_page_mode<MPHF>::value;
+        record.add("page_test_arrays", structure_pages ? "structure_and_keys" : "keys");
+        std::cerr << "Lookup time by page size"
+                  << (structure_pages ? "" : " of the keys (the structure keeps its pages)") << ":";
+        for (auto mode :
+             {mphf::PageMode::SMALL, mphf::PageMode::TRANSPARENT, mphf::PageMode::HUGE_2M}) {
+            mphf::scoped_page_mode scoped_mode(mode);
+            MPHF copy;
+            buffer.clear();
+            buffer.seekg(0);
+            copy.load(buffer);
+            mphf::huge_page_vector<T> copy_keys(keys.begin(), keys.end());
+            mphf::huge_page_vector<uint64_t> copy_queries(queries.begin(), queries.end());
+            double average_lookup_time = measure_lookup_time(copy, copy_keys, copy_queries);
+            std::cerr << " " << mphf::page_mode_name(mode) << " "
+                      << timeFormatter(average_lookup_time);
+            record.add(std::string("page_lookup_ns_per_key_") + mphf::page_mode_name(mode),
+                       average_lookup_time * 1e9);
+        }
+        const bool fallback = mphf::huge_page_fallbacks() != fallbacks;
+        std::cerr << (fallback ? " (no free 2m page, fell back to thp)" : "") << std::endl;
+        record.add("page_2m_fallback", fallback);
+    }
+
+    /**
+     * Prints and adds to `record` the hardware counters divided by `num_operations`
+     */
+    void report_counters(PerfCounters const& counters, std::string const& phase,
+                         uint64_t num_operations, ResultRecord& record,
+                         std::string const& prefix) const {
+        std::cerr << phase << " counters per key:";
+        for (int e = 0; e != PerfCounters::NUM_EVENTS; ++e) {
+            auto event = static_cast<PerfCounters::Event>(e);
+            double per_key = counters.value(event) / num_operations;
+            std::cerr << " " << PerfCounters::name(event) << "=";
+            if (std::isnan(per_key)) {
+                std::cerr << "n/a";
+            } else {
+                std::cerr << std::round(per_key * 100) / 100;
+            }
+            record.add(prefix + "_" + PerfCounters::name(event) + "_per_key", per_key);
+        }
+        double ipc = counters.value(PerfCounters::INSTRUCTIONS) /
+                     counters.value(PerfCounters::CYCLES);
+        if (!std::isnan(ipc)) std::cerr << " (IPC " << std::round(ipc * 100) / 100 << ")";
+        std::cerr << std::endl;
+    }
+
+    /**
+     * Writes a record of a failed test, filling the fields of the skipped phases
+     */
+    void report_failure(ResultRecord& record) const {
+        record.add("lookup_runs", num_lookup_runs);
+        record.add("lookup_ns_per_key", std::nan(""));
+        write(record);
+    }
+
+    /**
+     * Writes `record`, the result of the current test
+     */
+    void write(ResultRecord const& record) const {
+        writer.write(record);
+        results.back() = record;
+    }
+
+    ResultWriter& writer;
+    CycleTimer timer;
+    // positions of the keys to look up (empty = sequential scan), in the page mode of the keys
+    mphf::huge_page_vector<uint64_t> queries;
+    uint64_t num_missing_queries = 0;
 };
 
 enum Algorithm { FCH, CHD, BBhash, EMPHF, RecSplit, PTHash, PPTHash, ALL };
 
+template <typename T>
+struct TypeTag {
+    using type = T;
+};
+
+/**
+ * Calls `f` with a `TypeTag` of the PTHash encoder named `name`. With `VariantsOnly`, only the
+ * encoders of `pthash_variants` are dispatched, so that the tests of the predefined variants are
+ * not instantiated for the other encoders.
+ */
+template <bool VariantsOnly = false, typename Function>
+void with_pthash_encoder(std::string const& name, Function f) {
+    if (name == "compact_compact") return f(TypeTag<pthash::compact_compact>());
+    if (name == "dictionary_dictionary") return f(TypeTag<pthash::dictionary_dictionary>());
+    if (name == "elias_fano") return f(TypeTag<pthash::elias_fano>());
+    if constexpr (VariantsOnly) {
+        throw std::invalid_argument("The PTHash encoder `" + name +
+                                    "` is not one of the predefined variants");
+    } else {
+        if (name == "compact") return f(TypeTag<pthash::compact>());
+        if (name == "partitioned_compact") return f(TypeTag<pthash::partitioned_compact>());
+        if (name == "dictionary") return f(TypeTag<pthash::dictionary>());
+        throw std::invalid_argument("Unknown PTHash encoder `" + name +
+                                    "`, expected one of `compact`, `partitioned_compact`, "
+                                    "`compact_compact`, `dictionary`, `dictionary_dictionary`, "
+                                    "`elias_fano`");
+    }
+}
+
+/**
+ * Parameters of the PTHash and PPTHash variants 1-4 (single-threaded) and 5-8 (multi-threaded) of
+ * `test_algorithms`, whose encoders must be those of `with_pthash_encoder<true>`
+ */
+struct PTHashVariant {
+    std::string encoder;
+    double c, alpha;
+};
+
+const std::vector<PTHashVariant> pthash_variants{
+    {"compact_compact", 7, 0.99},
+    {"dictionary_dictionary", 11, 0.88},
+    {"elias_fano", 6, 0.99},
+    {"dictionary_dictionary", 7, 0.94},
+};
+
+/**
+ * Parameters of the RecSplit variants of `test_algorithms`
+ */
+struct RecSplitVariant {
+    uint64_t leaf_size, bucket_size;
+};
+
+constexpr RecSplitVariant recsplit_variants[] = {{5, 5}, {8, 100}, {12, 9}};
+
+#ifndef __APPLE__
+/**
+ * Calls `f` with the leaf size of RecSplit as a compile-time constant, which must be in
+ * [LEAF_SIZE, 16]
+ */
+template <size_t LEAF_SIZE = 4, typename Function>
+void with_recsplit_leaf_size(uint64_t leaf_size, Function f) {
+    if constexpr (LEAF_SIZE <= 16) {
+        if (leaf_size == LEAF_SIZE) return f(std::integral_constant<size_t, LEAF_SIZE>());
+        with_recsplit_leaf_size<LEAF_SIZE + 1>(leaf_size, f);
+    } else {
+        throw std::invalid_argument("The RecSplit leaf size must be between 4 and 16");
+    }
+}
+
+/**
+ * Calls `f` with the allocation type of RecSplit matching the default page mode, as a compile-time
+ * constant. Explicit huge pages are replaced by transparent ones if none is free, since RecSplit
+ * fails to allocate them otherwise. The huge-page allocation types are instantiated only for the
+ * leaf sizes of `recsplit_variants`, as each allocation type is a distinct instantiation of
+ * RecSplit: with huge pages, the other leaf sizes are rejected.
+ */
+template <size_t LEAF_SIZE, typename Function>
+void with_recsplit_alloc_type(Function f) {
+    using sux::util::AllocType;
+    constexpr bool variant_leaf_size = [] {
+        for (auto const& variant : recsplit_variants) {
+            if (variant.leaf_size == LEAF_SIZE) return true;
+        }
+        return false;
+    }();
+    if (mphf::default_page_mode() == mphf::PageMode::SMALL) {
+        return f(std::integral_constant<AllocType, AllocType::MALLOC>());
+    }
+    if constexpr (!variant_leaf_size) {
+        throw std::invalid_argument("RecSplit supports huge pages only with the leaf sizes of its "
+                                    "variants (5, 8, 12), not " +
+                                    std::to_string(LEAF_SIZE));
+    } else {
+        if (mphf::default_page_mode() == mphf::PageMode::HUGE_2M) {
+            if (mphf::free_huge_pages() != 0) {
+                return f(std::integral_constant<AllocType, AllocType::FORCEHUGEPAGE>());
+            }
+            std::cerr << "Warning: no free 2M huge page, RecSplit uses transparent huge pages"
+                      << std::endl;
+        }
+        return f(std::integral_constant<AllocType, AllocType::TRANSPARENT_HUGEPAGE>());
+    }
+}
+#endif
+
 template <typename T>
 void test_algorithms(TestEnvironment<T> const& testenv, Algorithm const& algorithm,
                      unsigned variant, unsigned threads_num) {
     using Hasher = mphf::hasher::Hasher<mphf::base_hasher::Murmur2BaseHasher>;
     // test the algorithms
     if (algorithm == FCH || algorithm == ALL) {
-        if (variant == 1 || variant == 0) testenv.test(mphf::FCH<Hasher>::Builder(3, 0.6, 0.3));
-        if (variant == 2 || variant == 0) testenv.test(mphf::FCH<Hasher>::Builder(4, 0.6, 0.3));
-        if (variant == 3 || variant == 0) testenv.test(mphf::FCH<Hasher>::Builder(5, 0.6, 0.3));
-        if (variant == 4 || variant == 0) testenv.test(mphf::FCH<Hasher>::Builder(6, 0.6, 0.3));
-        if (variant == 5 || variant == 0) testenv.test(mphf::FCH<Hasher>::Builder(7, 0.6, 0.3));
+        for (unsigned bits_per_key = 3; bits_per_key <= 7; ++bits_per_key) {
+            if (variant != bits_per_key - 2 && variant != 0) continue;
+            mphf::FCH<Hasher>::Builder builder(bits_per_key, 0.6, 0.3);
+            if (!testenv.key_hashes.empty()) {
+                builder.use_key_hashes(testenv.key_hashes, testenv.seed);
+            }
+            testenv.test(builder);
+        }
     }
 
     if (algorithm == CHD || algorithm == ALL) {
@@ -126,6 +1322,11 @@ void test_algorithms(TestEnvironment<T> const& testenv, Algorithm const& algorit
             testenv.test(typename mphf::BBhashWrapper<T, Hasher>::Builder(1.0));
         if (variant == 2 || variant == 0)
             testenv.test(typename mphf::BBhashWrapper<T, Hasher>::Builder(2.0));
+        if (threads_num <= 1 && (variant == 0 || variant > 2)) {
+            std::cerr << "Skipping the multi-threaded variants of BBhash: only one thread is "
+                         "available (see --threads)"
+                      << std::endl;
+        }
         if (threads_num > 1) {
             if (variant == 3 || variant == 0)
                 testenv.test(typename mphf::BBhashWrapper<T, Hasher>::Builder(1.0, threads_num));
@@ -142,82 +1343,652 @@ void test_algorithms(TestEnvironment<T> const& testenv, Algorithm const& algorit
             std::cerr << "RecSplit algorithm is not implemented on Apple" << std::endl;
         }
 #else
-        if (variant == 1 || variant == 0)
-            testenv.test(typename mphf::RecSplitWrapper<5>::Builder(5));
-        if (variant == 2 || variant == 0)
-            testenv.test(typename mphf::RecSplitWrapper<8>::Builder(100));
-        if (variant == 3 || variant == 0)
-            testenv.test(typename mphf::RecSplitWrapper<12>::Builder(9));
+        for (unsigned v = 1; v <= std::size(recsplit_variants); ++v) {
+            if (variant != v && variant != 0) continue;
+            const uint64_t bucket_size = recsplit_variants[v - 1].bucket_size;
+            with_recsplit_leaf_size(recsplit_variants[v - 1].leaf_size, [&](auto leaf) {
+                constexpr size_t LEAF_SIZE = decltype(leaf)::value;
+                with_recsplit_alloc_type<LEAF_SIZE>([&](auto alloc_type) {
+                    testenv.test(typename mphf::RecSplitWrapper<
+                                 LEAF_SIZE, decltype(alloc_type)::value>::Builder(bucket_size));
+                });
+            });
+        }
 #endif
     }
 
-    if (algorithm == PTHash || algorithm == ALL) {
-        if (variant == 1 || variant == 0)
-            testenv.test(
-                typename mphf::PTHashWrapper<false, pthash::compact_compact>::Builder(7.0, 0.99));
-        if (variant == 2 || variant == 0)
-            testenv.test(
-                typename mphf::PTHashWrapper<false, pthash::dictionary_dictionary>::Builder(11.0,
-                                                                                            0.88));
-        if (variant == 3 || variant == 0)
-            testenv.test(
-                typename mphf::PTHashWrapper<false, pthash::elias_fano>::Builder(6.0, 0.99));
-        if (variant == 4 || variant == 0)
-            testenv.test(
-                typename mphf::PTHashWrapper<false, pthash::dictionary_dictionary>::Builder(7.0,
-                                                                                            0.94));
-        if (threads_num > 1) {
-            if (variant == 5 || variant == 0)
-                testenv.test(typename mphf::PTHashWrapper<false, pthash::compact_compact>::Builder(
-                    7.0, 0.99, threads_num));
-            if (variant == 6 || variant == 0)
-                testenv.test(
-                    typename mphf::PTHashWrapper<false, pthash::dictionary_dictionary>::Builder(
-                        11.0, 0.88, threads_num));
-            if (variant == 7 || variant == 0)
-                testenv.test(typename mphf::PTHashWrapper<false, pthash::elias_fano>::Builder(
-                    6.0, 0.99, threads_num));
-            if (variant == 8 || variant == 0)
-                testenv.test(
-                    typename mphf::PTHashWrapper<false, pthash::dictionary_dictionary>::Builder(
-                        7.0, 0.94, threads_num));
-        }
-    }
-
-    if (algorithm == PPTHash || algorithm == ALL) {
-        auto keys_num = testenv.keys.size();
-        if (variant == 1 || variant == 0)
-            testenv.test(typename mphf::PTHashWrapper<true, pthash::compact_compact>::Builder(
-                7.0, 0.99, 1, keys_num));
-        if (variant == 2 || variant == 0)
-            testenv.test(typename mphf::PTHashWrapper<true, pthash::dictionary_dictionary>::Builder(
-                11.0, 0.88, 1, keys_num));
-        if (variant == 3 || variant == 0)
-            testenv.test(typename mphf::PTHashWrapper<true, pthash::elias_fano>::Builder(
-                6.0, 0.99, 1, keys_num));
-        if (variant == 4 || variant == 0)
-            testenv.test(typename mphf::PTHashWrapper<true, pthash::dictionary_dictionary>::Builder(
-                7.0, 0.94, 1, keys_num));
+    for (bool partitioned : {false, true}) {
+        if (algorithm != (partitioned ? PPTHash : PTHash) && algorithm != ALL) continue;
+        auto test_pthash = [&](PTHashVariant const& params, unsigned num_threads) {
+            with_pthash_encoder<true>(params.encoder, [&](auto tag) {
+                using Encoder = typename decltype(tag)::type;
+                if (partitioned) {
+                    testenv.test(typename mphf::PTHashWrapper<true, Encoder>::Builder(
+                        params.c, params.alpha, num_threads, testenv.keys.size()));
+                } else {
+                    testenv.test(typename mphf::PTHashWrapper<false, Encoder>::Builder(
+                        params.c, params.alpha, num_threads));
+                }
+            });
+        };
+        const unsigned num_variants = pthash_variants.size();
+        for (unsigned v = 1; v <= num_variants; ++v) {
+            if (variant == v || variant == 0) test_pthash(pthash_variants[v - 1], 1);
+        }
+        if (threads_num <= 1 && (variant == 0 || variant > num_variants)) {
+            std::cerr << "Skipping the multi-threaded variants of "
+                      << (partitioned ? "PPTHash" : "PTHash")
+                      << ": only one thread is available (see --threads)" << std::endl;
+        }
         if (threads_num > 1) {
-            if (variant == 5 || variant == 0)
-                testenv.test(typename mphf::PTHashWrapper<true, pthash::compact_compact>::Builder(
-                    7.0, 0.99, threads_num, keys_num));
-            if (variant == 6 || variant == 0)
-                testenv.test(
-                    typename mphf::PTHashWrapper<true, pthash::dictionary_dictionary>::Builder(
-                        11.0, 0.88, threads_num, keys_num));
-            if (variant == 7 || variant == 0)
-                testenv.test(typename mphf::PTHashWrapper<true, pthash::elias_fano>::Builder(
-                    6.0, 0.99, threads_num, keys_num));
-            if (variant == 8 || variant == 0)
-                testenv.test(
-                    typename mphf::PTHashWrapper<true, pthash::dictionary_dictionary>::Builder(
-                        7.0, 0.94, threads_num, keys_num));
+            for (unsigned v = 1; v <= num_variants; ++v) {
+                if (variant == num_variants + v || variant == 0) {
+                    test_pthash(pthash_variants[v - 1], threads_num);
+                }
+            }
         }
     }
 }
 
-int main(int argc, char** argv) {
+/**
+ * Parameters of the builders of each algorithm that can be swept
+ */
+const std::vector<std::pair<Algorithm, std::vector<std::string>>> sweep_parameters{
+    {FCH, {"bits_per_key", "perc_keys_first_part", "perc_buckets_first_part"}},
+    {CHD, {"lambda"}},
+    {BBhash, {"gamma", "threads"}},
+    {RecSplit, {"leaf_size", "bucket_size"}},
+    {PTHash, {"encoder", "c", "alpha", "threads"}},
+    {PPTHash, {"encoder", "c", "alpha", "threads"}},
+};
+
+/**
+ * Checks that the parameters of `grid` belong to the selected algorithms, and that the values
+ * selecting types (PTHash encoders, RecSplit leaf sizes) are supported
+ */
+void validate_sweep(ParameterGrid const& grid, Algorithm const& algorithm) {
+    for (auto const& name : grid.names()) {
+        bool found = false;
+        for (auto const& [parameter_algorithm, names] : sweep_parameters) {
+            if (algorithm != ALL && algorithm != parameter_algorithm) continue;
+            found |= std::find(names.begin(), names.end(), name) != names.end();
+        }
+        if (!found) {
+            throw std::invalid_argument("Sweep parameter `" + name +
+                                        "` does not belong to the selected algorithm");
+        }
+    }
+    for (auto const& encoder : grid.values("encoder", {})) {
+        with_pthash_encoder(encoder, [](auto) {});
+    }
+    grid.integers("threads", {});
+#ifndef __APPLE__
+    for (uint64_t leaf_size : grid.integers("leaf_size", {})) {
+        with_recsplit_leaf_size(leaf_size, [](auto) {});
+    }
+#endif
+}
+
+/**
+ * Calls `run` for every combination of the parameter values of `grid` of the builders of the
+ * selected algorithms, always in the same order. The parameters missing from `grid` keep the
+ * values of the variants of `test_algorithms`: the given values replace the ones of each variant
+ * (e.g., `c=5:9` tests every encoder and alpha of the PTHash variants with each c), and the
+ * number of threads is 1 and `threads_num`. `run` receives a function returning the builder for a
+ * given number of keys, which throws `std::invalid_argument` if the combination is not valid.
+ */
+template <typename T, typename Function>
+void for_each_configuration(Algorithm const& algorithm, ParameterGrid const& grid,
+                            unsigned threads_num, Function run) {
+    using Hasher = mphf::hasher::Hasher<mphf::base_hasher::Murmur2BaseHasher>;
+    std::vector<uint64_t> default_threads{1};
+    if (threads_num > 1) default_threads.push_back(threads_num);
+    auto threads = grid.integers("threads", default_threads);
+
+    if (algorithm == FCH || algorithm == ALL) {
+        for (double bits_per_key : grid.numbers("bits_per_key", {3, 4, 5, 6, 7})) {
+            for (double perc_keys : grid.numbers("perc_keys_first_part", {0.6})) {
+                for (double perc_buckets : grid.numbers("perc_buckets_first_part", {0.3})) {
+                    run([&](uint64_t) {
+                        return mphf::FCH<Hasher>::Builder(bits_per_key, perc_keys, perc_buckets);
+                    });
+                }
+            }
+        }
+    }
+
+    if (algorithm == CHD || algorithm == ALL) {
+        for (double lambda : grid.numbers("lambda", {1, 2, 3, 4, 5, 6})) {
+            run([&](uint64_t) { return mphf::CHDWrapper::Builder(lambda); });
+        }
+    }
+
+    if (algorithm == EMPHF || algorithm == ALL) {
+        run([](uint64_t) { return mphf::EMPHFWrapper::Builder(); });
+        run([](uint64_t) { return mphf::EMPHFHEMWrapper::Builder(); });
+    }
+
+    if (algorithm == BBhash || algorithm == ALL) {
+        for (double gamma : grid.numbers("gamma", {1, 2})) {
+            for (uint64_t num_threads : threads) {
+                run([&](uint64_t) {
+                    return typename mphf::BBhashWrapper<T, Hasher>::Builder(gamma, num_threads);
+                });
+            }
+        }
+    }
+
+    if (algorithm == RecSplit || algorithm == ALL) {
+#ifdef __APPLE__
+        if (algorithm == RecSplit) {
+            throw std::runtime_error("RecSplit algorithm is not implemented on Apple");
+        } else {
+            std::cerr << "RecSplit algorithm is not implemented on Apple" << std::endl;
+        }
+#else
+        std::vector<RecSplitVariant> variants;
+        for (auto const& variant : recsplit_variants) {
+            for (uint64_t leaf_size : grid.integers("leaf_size", {variant.leaf_size})) {
+                for (uint64_t bucket_size : grid.integers("bucket_size", {variant.bucket_size})) {
+                    if (std::none_of(variants.begin(), variants.end(), [&](auto const& other) {
+                            return other.leaf_size == leaf_size &&
+                                   other.bucket_size == bucket_size;
+                        })) {
+                        variants.push_back({leaf_size, bucket_size});
+                    }
+                }
+            }
+        }
+        for (auto const& [leaf_size, bucket_size] : variants) {
+            with_recsplit_leaf_size(leaf_size, [&, bucket_size = bucket_size](auto leaf) {
+                constexpr size_t LEAF_SIZE = decltype(leaf)::value;
+                with_recsplit_alloc_type<LEAF_SIZE>([&](auto alloc_type) {
+                    run([&](uint64_t) {
+                        return typename mphf::RecSplitWrapper<
+                            LEAF_SIZE, decltype(alloc_type)::value>::Builder(bucket_size);
+                    });
+                });
+            });
+        }
+#endif
+    }
+
+    std::vector<PTHashVariant> variants;
+    for (auto const& variant : pthash_variants) {
+        for (auto const& encoder : grid.values("encoder", {variant.encoder})) {
+            for (double c : grid.numbers("c", {variant.c})) {
+                for (double alpha : grid.numbers("alpha", {variant.alpha})) {
+                    if (std::none_of(variants.begin(), variants.end(), [&](auto const& other) {
+                            return other.encoder == encoder && other.c == c &&
+                                   other.alpha == alpha;
+                        })) {
+                        variants.push_back({encoder, c, alpha});
+                    }
+                }
+            }
+        }
+    }
+    for (bool partitioned : {false, true}) {
+        if (algorithm != (partitioned ? PPTHash : PTHash) && algorithm != ALL) continue;
+        for (uint64_t num_threads : threads) {
+            for (auto const& [encoder, c, alpha] : variants) {
+                with_pthash_encoder(encoder, [&, c = c, alpha = alpha](auto tag) {
+                    using Encoder = typename decltype(tag)::type;
+                    if (partitioned) {
+                        run([&](uint64_t num_keys) {
+                            return typename mphf::PTHashWrapper<true, Encoder>::Builder(
+                                c, alpha, num_threads, num_keys);
+                        });
+                    } else {
+                        run([&](uint64_t) {
+                            return typename mphf::PTHashWrapper<false, Encoder>::Builder(
+                                c, alpha, num_threads);
+                        });
+                    }
+                });
+            }
+        }
+    }
+}
+
+/**
+ * Tests every configuration of `for_each_configuration`, then prints and writes the ones on the
+ * Pareto frontier of space, construction time and lookup time
+ */
+template <typename T>
+void sweep_algorithms(TestEnvironment<T> const& testenv, Algorithm const& algorithm,
+                      ParameterGrid const& grid, ResultWriter& writer) {
+    std::vector<ResultRecord> results;
+    for_each_configuration<T>(algorithm, grid, testenv.config.num_threads, [&](auto make) {
+        try {
+            ResultRecord record = testenv.test(make(testenv.keys.size()));
+            if (record.contains("verification")) results.push_back(record);
+        } catch (std::invalid_argument const& e) {
+            std::cerr << "Skipped configuration: " << e.what() << std::endl << std::endl;
+        } catch (std::runtime_error const& e) {
+            std::cerr << "Failed configuration: " << e.what() << std::endl << std::endl;
+        }
+    });
+
+    // objectives to minimize: space, construction time and lookup time per key (an objective
+    // that no test measured, such as the construction time in lookup-only mode, is ignored)
+    std::vector<std::vector<double>> points;
+    for (auto const& record : results) {
+        points.push_back({record.number("bits_per_key"),
+                          record.number("avg_construction_seconds") / record.number("n") * 1e9,
+                          record.number("lookup_ns_per_key")});
+    }
+    for (size_t objective = 0; objective != 3; ++objective) {
+        bool measured = false;
+        for (auto const& point : points) measured |= !std::isnan(point[objective]);
+        if (!measured) {
+            for (auto& point : points) point[objective] = 0;
+        }
+    }
+    std::vector<size_t> frontier = pareto_frontier(points);
+    std::sort(frontier.begin(), frontier.end(),
+              [&](size_t a, size_t b) { return points[a] < points[b]; });
+
+    std::cerr << "Pareto frontier: " << frontier.size() << " of " << results.size()
+              << " configurations (bits/key, construction ns/key, lookup ns/key)" << std::endl;
+    for (size_t i : frontier) {
+        auto const& record = results[i];
+        double construction_ns = points[i][1];
+        std::cerr << "  " << std::round(100 * record.number("bits_per_key")) / 100 << "\t"
+                  << std::round(100 * construction_ns) / 100 << "\t"
+                  << std::round(100 * record.number("lookup_ns_per_key")) / 100 << "\t"
+                  << record.text("algorithm") << std::endl;
+
+        ResultRecord summary;
+        summary.add("sweep", "pareto_frontier");
+        summary.add("algorithm", record.text("algorithm"));
+        summary.add("n", static_cast<uint64_t>(record.number("n")));
+        summary.add("key_type", record.text("key_type"));
+        summary.add("sweep_configurations", results.size());
+        summary.add("bits_per_key", record.number("bits_per_key"));
+        summary.add("construction_ns_per_key", construction_ns);
+        summary.add("lookup_ns_per_key", record.number("lookup_ns_per_key"));
+        writer.write(summary);
+    }
+}
+
+/**
+ * Picks the configuration of `for_each_configuration` that minimizes the objective of `budget`
+ * among those meeting its constraints on the target number of keys. Each configuration is tested
+ * on three prefixes of the keys (the sample, a quarter and a sixteenth of it), and its space,
+ * construction time and lookup time are extrapolated to the target number of keys. If required,
+ * the best configuration is then tested on all the keys.
+ * @return Whether a configuration meets the budget
+ */
+template <typename T>
+bool tune_algorithms(TestEnvironment<T> const& testenv, Algorithm const& algorithm,
+                     ParameterGrid const& grid, TuningBudget const& budget,
+                     ResultWriter& writer) {
+    const uint64_t num_keys = testenv.keys.size();
+    const uint64_t target_num_keys = budget.target_num_keys ? budget.target_num_keys : num_keys;
+    const uint64_t sample_size = std::min(budget.sample_size, num_keys);
+    const std::vector<uint64_t> sample_sizes{std::max<uint64_t>(sample_size / 16, 1),
+                                             std::max<uint64_t>(sample_size / 4, 1), sample_size};
+    const std::vector<double> trial_sizes(sample_sizes.begin(), sample_sizes.end());
+
+    // the trials run only the construction and the lookup test, and write no records
+    TestConfiguration trial_config;
+    trial_config.num_lookup_runs = testenv.config.num_lookup_runs;
+    trial_config.seed = testenv.seed;
+    trial_config.generator = testenv.config.generator;
+    trial_config.num_threads = testenv.config.num_threads;
+    if (testenv.config.workload.distribution != QueryDistribution::TRACE) {
+        trial_config.workload = testenv.config.workload;
+    }
+    ResultWriter trial_writer(std::cerr, OutputFormat::TEXT);
+    // the configurations are identified by their name for all the keys, which does not depend on
+    // the size of the trials (unlike, e.g., the partitions of PPTHash in the name of the trials)
+    std::vector<std::string> configurations;
+    std::vector<std::map<std::string, ResultRecord>> trials(sample_sizes.size());
+    for (size_t i = 0; i != sample_sizes.size(); ++i) {
+        std::cerr << "Tuning trials on " << sample_sizes[i] << " keys" << std::endl << std::endl;
+        TestEnvironment<T> sample(testenv, sample_sizes[i], trial_config, trial_writer);
+        for_each_configuration<T>(algorithm, grid, testenv.config.num_threads, [&](auto make) {
+            try {
+                const std::string name = make(num_keys).name();
+                if (i == 0 && std::find(configurations.begin(), configurations.end(), name) ==
+                                  configurations.end()) {
+                    configurations.push_back(name);
+                }
+                trials[i][name] = sample.test(make(sample_sizes[i]));
+            } catch (std::invalid_argument const& e) {
+                std::cerr << "Skipped configuration: " << e.what() << std::endl << std::endl;
+            } catch (std::runtime_error const& e) {
+                std::cerr << "Failed configuration: " << e.what() << std::endl << std::endl;
+            }
+        });
+    }
+
+    struct Prediction {
+        std::string algorithm;  // name of the configuration for all the keys
+        double bits_per_key, construction_seconds, lookup_ns_per_key, objective;
+        bool feasible;
+    };
+    std::vector<Prediction> predictions;
+    for (std::string const& name : configurations) {
+        if (std::any_of(trials.begin(), trials.end(), [&](auto const& records) {
+                auto it = records.find(name);
+                return it == records.end() || !it->second.contains("verification");
+            })) {
+            continue;
+        }
+        ResultRecord const& large = trials.back().at(name);
+        auto measures = [&](std::string const& metric) {
+            std::vector<double> values;
+            for (auto const& records : trials) values.push_back(records.at(name).number(metric));
+            return values;
+        };
+        Prediction p;
+        p.algorithm = name;
+        // the space per key is almost constant, while the construction time grows between
+        // linearly and as n log n, and the lookup time per key grows with the size of the
+        // structure at most as the depth of a memory hierarchy, i.e., logarithmically
+        p.bits_per_key = large.number("bits_per_key");
+        p.construction_seconds =
+            extrapolate(trial_sizes, measures("avg_construction_seconds"), target_num_keys,
+                        Growth::LINEAR, Growth::LINEARITHMIC);
+        p.lookup_ns_per_key = extrapolate(trial_sizes, measures("lookup_ns_per_key"),
+                                          target_num_keys, Growth::CONSTANT, Growth::LOGARITHMIC);
+        switch (budget.objective) {
+            case TuningObjective::LOOKUP:
+                p.objective = p.lookup_ns_per_key;
+                break;
+            case TuningObjective::CONSTRUCTION:
+                p.objective = p.construction_seconds;
+                break;
+            case TuningObjective::SPACE:
+                p.objective = p.bits_per_key;
+                break;
+        }
+        p.feasible = p.bits_per_key <= budget.max_bits_per_key &&
+                     p.construction_seconds <= budget.max_construction_seconds &&
+                     !std::isnan(p.objective);
+        predictions.push_back(p);
+    }
+    std::sort(predictions.begin(), predictions.end(), [](auto const& a, auto const& b) {
+        if (a.feasible != b.feasible) return a.feasible;
+        return a.objective < b.objective;
+    });
+
+    std::cerr << "Predictions for " << target_num_keys
+              << " keys (bits/key, construction time, lookup ns/key, budget):" << std::endl;
+    for (auto const& p : predictions) {
+        std::cerr << "  " << std::round(100 * p.bits_per_key) / 100 << "\t"
+                  << TimeFormatter::format(p.construction_seconds) << "\t"
+                  << std::round(100 * p.lookup_ns_per_key) / 100 << "\t"
+                  << (p.feasible ? "met" : "exceeded") << "\t" << p.algorithm << std::endl;
+    }
+    if (predictions.empty() || !predictions.front().feasible) {
+        std::cerr << "No configuration meets the budget" << std::endl;
+        return false;
+    }
+    Prediction const& best = predictions.front();
+    std::cerr << "Best configuration: " << best.algorithm << std::endl << std::endl;
+
+    ResultRecord record;
+    record.add("tune", "best");
+    record.add("algorithm", best.algorithm);
+    record.add("n", target_num_keys);
+    record.add("key_type", key_type_name<T>());
+    record.add("tune_sample_sizes", sample_sizes);
+    record.add("tune_configurations", configurations.size());
+    record.add("predicted_bits_per_key", best.bits_per_key);
+    record.add("predicted_construction_seconds", best.construction_seconds);
+    record.add("predicted_lookup_ns_per_key", best.lookup_ns_per_key);
+    writer.write(record);
+
+    if (budget.full_build) {
+        bool built = false;
+        for_each_configuration<T>(algorithm, grid, testenv.config.num_threads, [&](auto make) {
+            std::string name;
+            try {
+                name = make(num_keys).name();
+            } catch (std::invalid_argument const&) {
+                return;  // skipped by the trials
+            }
+            if (!built && name == best.algorithm) {
+                built = true;
+                testenv.test(make(num_keys));
+            }
+        });
+    }
+    return true;
+}
+
+/**
+ * Tests the construction of each variant of the selected algorithms that can run on multiple
+ * threads (BBhash, PTHash and PPTHash) with 1, 2, 4, ... threads, up to `max_threads`, and
+ * reports the speedup and parallel efficiency of the construction with respect to one thread.
+ * Only the construction runs and the verification are run for each number of threads.
+ * `variant` selects the single-threaded variant of `test_algorithms` to scale (0 = all).
+ */
+template <typename T>
+void test_thread_scaling(TestEnvironment<T> const& testenv, Algorithm const& algorithm,
+                         unsigned variant, unsigned max_threads, ResultWriter& writer) {
+    using Hasher = mphf::hasher::Hasher<mphf::base_hasher::Murmur2BaseHasher>;
+    const uint64_t keys_num = testenv.keys.size();
+    // tests the builders returned by `make` for each number of threads
+    auto scale = [&](std::string const& label, auto make) {
+        std::vector<uint64_t> threads_series;
+        std::vector<double> seconds, speedups, efficiencies;
+        for (unsigned num_threads = 1; true; num_threads *= 2) {
+            num_threads = std::min(num_threads, max_threads);
+            ResultRecord record = testenv.test(make(num_threads), true);
+            threads_series.push_back(num_threads);
+            seconds.push_back(record.number("avg_construction_seconds"));
+            speedups.push_back(seconds.front() / seconds.back());
+            efficiencies.push_back(speedups.back() / num_threads);
+            if (num_threads == max_threads) break;
+        }
+        std::cerr << "Construction thread scaling of " << label
+                  << " (threads, time, speedup, efficiency):" << std::endl;
+        for (size_t i = 0; i != threads_series.size(); ++i) {
+            std::cerr << "  " << threads_series[i] << "\t" << TimeFormatter::format(seconds[i])
+                      << "\t" << std::round(100 * speedups[i]) / 100 << "x\t"
+                      << std::round(1000 * efficiencies[i]) / 10 << "%" << std::endl;
+        }
+        std::cerr << std::endl;
+
+        ResultRecord summary;
+        summary.add("thread_scaling", label);
+        summary.add("n", keys_num);
+        summary.add("key_type", key_type_name<T>());
+        summary.add("thread_scaling_threads", threads_series);
+        summary.add("thread_scaling_construction_seconds", seconds);
+        summary.add("thread_scaling_speedup", speedups);
+        summary.add("thread_scaling_efficiency", efficiencies);
+        writer.write(summary);
+    };
+
+    if (algorithm == BBhash || algorithm == ALL) {
+        for (unsigned v = 1; v <= 2; ++v) {
+            if (variant != v && variant != 0) continue;
+            double gamma = v;
+            std::stringstream label;
+            label << "BBhash(gamma=" << gamma << ")";
+            scale(label.str(), [&](unsigned num_threads) {
+                return typename mphf::BBhashWrapper<T, Hasher>::Builder(gamma, num_threads);
+            });
+        }
+    }
+
+    for (bool partitioned : {false, true}) {
+        if (algorithm != (partitioned ? PPTHash : PTHash) && algorithm != ALL) continue;
+        std::string prefix = partitioned ? "PPTHash" : "PTHash";
+        // the single-threaded variants of `test_algorithms`
+        for (unsigned v = 1; v <= pthash_variants.size(); ++v) {
+            if (variant != v && variant != 0) continue;
+            auto const& [encoder, c, alpha] = pthash_variants[v - 1];
+            std::stringstream label;
+            label << prefix << "(encoder=" << encoder << ", c=" << c << ", alpha=" << alpha << ")";
+            with_pthash_encoder<true>(encoder, [&](auto tag) {
+                using Encoder = typename decltype(tag)::type;
+                if (partitioned) {
+                    scale(label.str(), [&](unsigned num_threads) {
+                        return typename mphf::PTHashWrapper<true, Encoder>::Builder(
+                            c, alpha, num_threads, keys_num);
+                    });
+                } else {
+                    scale(label.str(), [&](unsigned num_threads) {
+                        return typename mphf::PTHashWrapper<false, Encoder>::Builder(c, alpha,
+                                                                                     num_threads);
+                    });
+                }
+            });
+        }
+    }
+}
+
+/**
+ * Runs `run_tests` on the prefixes of the keys of `testenv` of log-spaced sizes, from
+ * `min_num_keys` to all the keys with `points_per_decade` sizes per decade, then prints how the
+ * construction time, space and lookup time of each tested variant vary with the number of keys.
+ * The prefixes share the negative keys of `testenv`.
+ */
+template <typename T, typename Function>
+void test_scaling(TestEnvironment<T> const& testenv, uint64_t min_num_keys,
+                  uint32_t points_per_decade, ResultWriter& writer, Function run_tests) {
+    const uint64_t num_keys = testenv.keys.size();
+    std::vector<uint64_t> sizes;
+    for (uint32_t i = 0; true; ++i) {
+        uint64_t size = std::round(min_num_keys * std::pow(10.0, 1.0 * i / points_per_decade));
+        if (size >= num_keys) break;
+        if (sizes.empty() || size != sizes.back()) sizes.push_back(size);
+    }
+    sizes.push_back(num_keys);
+
+    std::vector<std::vector<ResultRecord>> results;  // results of each size
+    for (uint64_t size : sizes) {
+        std::cerr << "Scaling: " << size << " keys" << std::endl << std::endl;
+        if (size == num_keys) {
+            size_t first = testenv.results.size();
+            run_tests(testenv);
+            results.emplace_back(testenv.results.begin() + first, testenv.results.end());
+        } else {
+            TestEnvironment<T> prefix(testenv, size, testenv.config, writer);
+            run_tests(prefix);
+            results.push_back(prefix.results);
+        }
+    }
+
+    // the tests of the sizes are matched by their variant, so that a variant skipped at some
+    // sizes does not shift the others (the k-th test of a variant at a size is matched with the
+    // k-th one at the other sizes)
+    std::vector<std::string> variants;  // in order of first test
+    std::set<std::string> seen;
+    std::vector<std::map<std::string, ResultRecord const*>> tested(sizes.size());
+    for (size_t j = 0; j != sizes.size(); ++j) {
+        std::map<std::string, uint64_t> occurrences;
+        for (auto const& record : results[j]) {
+            std::string name = record.text("algorithm");
+            std::string variant = name + "#" + std::to_string(occurrences[name]++);
+            if (seen.insert(variant).second) variants.push_back(variant);
+            tested[j][variant] = &record;
+        }
+    }
+    for (auto const& variant : variants) {
+        std::cerr << "Scaling of " << variant.substr(0, variant.rfind('#'))
+                  << " (n, construction ns/key, bits/key, lookup ns/key):" << std::endl;
+        for (size_t j = 0; j != sizes.size(); ++j) {
+            auto it = tested[j].find(variant);
+            std::cerr << "  " << sizes[j];
+            if (it == tested[j].end()) {
+                std::cerr << "\tnot tested" << std::endl;
+                continue;
+            }
+            ResultRecord const* record = it->second;
+            if (!record->contains("verification")) {
+                std::cerr << "\tfailed" << std::endl;
+                continue;
+            }
+            double construction_ns = record->number("avg_construction_seconds") / sizes[j] * 1e9;
+            std::cerr << "\t" << std::round(100 * construction_ns) / 100 << "\t"
+                      << std::round(100 * record->number("bits_per_key")) / 100 << "\t"
+                      << std::round(100 * record->number("lookup_ns_per_key")) / 100
+                      << std::endl;
+        }
+    }
+}
+
+/**
+ * Compares `results` with the baseline, printing the change of each metric and writing it as a
+ * record, then lists the variants that regressed
+ * @return Whether no variant regressed
+ */
+bool compare_to_baseline(BaselineComparison const& baseline,
+                         std::vector<ResultRecord> const& results, ResultWriter& writer) {
+    std::vector<MetricComparison> comparisons = baseline.compare(results);
+    std::vector<std::string> regressed;
+    uint64_t num_inconclusive = 0;
+    std::cerr << "Comparison with the baseline (median, change, threshold):" << std::endl;
+    for (size_t i = 0; i != comparisons.size(); ++i) {
+        auto const& comparison = comparisons[i];
+        if (i == 0 || comparison.variant != comparisons[i - 1].variant) {
+            std::cerr << "  " << comparison.variant << std::endl;
+        }
+        std::cerr << "    " << comparison.metric << ": " << comparison.baseline.median << " -> "
+                  << comparison.current.median << " (";
+        if (std::isnan(comparison.change)) {
+            std::cerr << "n/a";
+        } else {
+            std::cerr << (comparison.change > 0 ? "+" : "")
+                      << std::round(comparison.change * 1000) / 10 << "%";
+        }
+        std::cerr << " worse, threshold " << comparison.threshold * 100 << "%, "
+                  << comparison.baseline.count << " vs " << comparison.current.count
+                  << " samples)" << (comparison.conclusive ? "" : " inconclusive")
+                  << (comparison.regressed ? " REGRESSION" : "") << std::endl;
+        if (!comparison.conclusive) ++num_inconclusive;
+        if (comparison.regressed &&
+            (regressed.empty() || regressed.back() != comparison.variant)) {
+            regressed.push_back(comparison.variant);
+        }
+
+        ResultRecord record;
+        record.add("baseline_variant", comparison.variant);
+        record.add("baseline_metric", comparison.metric);
+        record.add("baseline_median", comparison.baseline.median);
+        record.add("baseline_samples", comparison.baseline.count);
+        record.add("current_median", comparison.current.median);
+        record.add("current_samples", comparison.current.count);
+        record.add("change_percent", comparison.change * 100);
+        record.add("threshold_percent", comparison.threshold * 100);
+        record.add("conclusive", comparison.conclusive);
+        record.add("regressed", comparison.regressed);
+        writer.write(record);
+    }
+    for (auto const& variant : baseline.missing(results)) {
+        std::cerr << "  " << variant << ": not tested in this run" << std::endl;
+    }
+    if (comparisons.empty()) {
+        std::cerr << "Warning: no tested variant is in the baseline" << std::endl;
+    }
+    if (num_inconclusive != 0) {
+        std::cerr << "Warning: " << num_inconclusive << " of " << comparisons.size()
+                  << " metrics are inconclusive, with fewer than "
+                  << BaselineComparison::min_samples
+                  << " samples (e.g., failed tests) or a zero baseline, and cannot regress"
+                  << std::endl;
+    }
+    if (regressed.empty()) {
+        std::cerr << "No regression" << std::endl;
+        return true;
+    }
+    std::cerr << regressed.size() << " regressed variants:" << std::endl;
+    for (auto const& variant : regressed) std::cerr << "  " << variant << std::endl;
+    return false;
+}
+
+/**
+ * Parses the options, creates or reads the keys and runs the tests
+ * @return The exit code of the benchmark
+ */
+int run_benchmark(int argc, char** argv) {
     cmd_line_parser::parser parser(argc, argv);
     parser.add("algorithm",
                "The name of the algorithm to run. One among `fch`, `chd`, "
@@ -242,8 +2013,188 @@ int main(int argc, char** argv) {
     parser.add("generator",
                "The method of generating keys, one of: "
                "`64` (default if -n is given), `xs32` (xor-shift 32), `xs64` (xor-shift 64), "
-               "`stdin` (strings from stdin; default if -n is not given)",
+               "`stdin` (strings from stdin; default if -n is not given), `file` (strings from "
+               "--input; default if --input is given)",
                "--gen", false);
+    parser.add("input",
+               "Read the keys from this file, one per line, by memory-mapping it and viewing the "
+               "keys in place instead of copying each one into a string. Files compressed by gzip "
+               "or zstd are decompressed by a thread while the keys are split. (default: none)",
+               "--input", false);
+    parser.add("parse_threads",
+               "Number of threads splitting the file of --input, or the standard input with "
+               "--pipeline, into keys. (default: all the hardware threads)",
+               "--parse_threads", false);
+    parser.add("pipeline",
+               "Read the keys from stdin in blocks, which are split into keys by --parse_threads "
+               "threads while the next blocks are read, and view them in place instead of copying "
+               "each one into a string. (default: false)",
+               "--pipeline", true);
+    parser.add("input_format",
+               "Format of the file of --input, one of: `text` (default; one key per line), `u32`, "
+               "`u64`, `u128` (raw arrays of little-endian integers), `strings` (length-prefixed "
+               "strings with an index). The binary formats are written by `convert_keys`.",
+               "--input_format", false);
+    parser.add("format",
+               "Format of the results written on the standard output, one of: "
+               "`text` (default; human-readable report only), `json` (one record per line), "
+               "`csv`. The human-readable report is always written on the standard error.",
+               "--format", false);
+    parser.add("latency_samples",
+               "Number of single lookups to time individually, in order to report the latency "
+               "percentiles and histogram of each variant. (default: 0 = disabled)",
+               "--latency_samples", false);
+    parser.add("negative_keys",
+               "Number of keys not belonging to the set to query in a separate lookup test. They "
+               "are created by the same generator of the keys, or held out from the end of the "
+               "input when keys are read from stdin. (default: 0 = disabled)",
+               "--negative_keys", false);
+    parser.add("queries",
+               "Order of the lookups, one of: `sequential` (default; the keys in the order they "
+               "are stored), `uniform` (drawn uniformly at random), `zipf` (drawn from a Zipfian "
+               "distribution), `sorted` (the keys sorted by value), `trace` (the keys listed in "
+               "the file given by --query_trace, one per line).",
+               "--queries", false);
+    parser.add("num_queries",
+               "Number of lookups drawn by the `uniform` and `zipf` query distributions. "
+               "(default: 0 = as many as the keys)",
+               "--num_queries", false);
+    parser.add("zipf_skew", "Skew of the `zipf` query distribution. (default: 1.0)",
+               "--zipf_skew", false);
+    parser.add("query_trace",
+               "File with the keys to look up, one per line, replayed by the `trace` query "
+               "distribution. Keys not belonging to the set are skipped.",
+               "--query_trace", false);
+    parser.add("lookup_threads",
+               "Maximum number of threads concurrently looking up the same structure. The "
+               "parallel lookup test runs with 1, 2, 4, ... threads up to this number. "
+               "(default: 0 = disabled)",
+               "--lookup_threads", false);
+    parser.add("batch_sizes",
+               "Comma-separated list of batch sizes for the batched lookup test, which compares "
+               "the lookup time of `lookup_batch` with that of single-key lookups. "
+               "(default: disabled)",
+               "--batch_sizes", false);
+    parser.add("perf",
+               "Read the hardware performance counters (cycles, instructions, LLC misses, dTLB "
+               "misses, branch misses) during construction and lookup, reporting them per key. "
+               "(default: false)",
+               "--perf", true);
+    parser.add("memory",
+               "Measure the peak increase of the heap usage and of the resident set size during "
+               "each construction run. (default: false)",
+               "--memory", true);
+    parser.add("num_seeds",
+               "Repeat the construction and the lookup test with this many distinct seeds "
+               "(starting from --seed), reporting the median, minimum, standard deviation and "
+               "95% confidence interval of each metric, and the failed constructions. "
+               "(default: 1 = disabled)",
+               "--num_seeds", false);
+    parser.add("cache_mode",
+               "State of the caches during an additional latency test: `warm` (no test), `cold` "
+               "(the caches are flushed every --cache_batch_size lookups) or `antagonist` (a "
+               "concurrent thread streams over memory). (default: warm)",
+               "--cache_mode", false);
+    parser.add("cache_scratch_mb",
+               "Size in MiB of the buffer used to pollute the caches. (default: 4 times the "
+               "last-level cache, or 64)",
+               "--cache_scratch_mb", false);
+    parser.add("cache_batch_size",
+               "Number of lookups between two cache flushes in `cold` mode. (default: 1000)",
+               "--cache_batch_size", false);
+    parser.add("cache_lookups", "Number of lookups timed under cache pressure. (default: 100000)",
+               "--cache_lookups", false);
+    parser.add("save",
+               "Save each built structure to `<save><algorithm>.mphf`, and measure the time to "
+               "load it back by reading the file and by memory-mapping it.",
+               "--save", false);
+    parser.add("load",
+               "Lookup-only mode: instead of building each structure, load it from "
+               "`<load><algorithm>.mphf`, as saved by --save on the same keys, and run only the "
+               "verification and the lookup tests. Variants without a saved file are skipped.",
+               "--load", false);
+    parser.add("sweep",
+               "Test every combination of the parameter values in the given specification, "
+               "instead of the predefined variants, and report the Pareto frontier of space, "
+               "construction time and lookup time. The specification lists the values of each "
+               "parameter, e.g., `bits_per_key=2:8:0.5;perc_keys_first_part=0.5,0.6` (see the "
+               "README for the parameters of each algorithm and their defaults).",
+               "--sweep", false);
+    parser.add("scaling",
+               "Repeat the tests on prefixes of the keys of log-spaced sizes, from this number of "
+               "keys to all of them, and report how construction time, space and lookup time "
+               "vary with the number of keys. (default: 0 = disabled)",
+               "--scaling", false);
+    parser.add("scaling_points",
+               "Number of sizes per decade of the scaling series. (default: 1)",
+               "--scaling_points", false);
+    parser.add("numa",
+               "NUMA test: measure the lookup throughput of --numa_threads readers pinned to each "
+               "node, with a copy of the structure and of the keys placed by one of: `bind` (on "
+               "--numa_node, comparing local and remote readers), `interleave` (over all the "
+               "nodes), `replicate` (one copy per node, compared to a shared copy). "
+               "(default: none)",
+               "--numa", false);
+    parser.add("numa_node",
+               "ID of the node of the copy in `bind` mode. (default: the first node with CPUs)",
+               "--numa_node", false);
+    parser.add("numa_threads", "Number of readers per node in the NUMA test. (default: 1)",
+               "--numa_threads", false);
+    parser.add("huge_pages",
+               "Pages backing the arrays of the structures (FCH, RecSplit) and of their "
+               "construction: `4k` (default pages), `thp` (transparent huge pages), `2m` (explicit "
+               "2 MiB huge pages, falling back to `thp` if none is free). (default: 4k)",
+               "--huge_pages", false);
+    parser.add("page_test",
+               "Compare the lookup time on copies of the structure and of the keys backed by 4k, "
+               "transparent huge and explicit 2 MiB pages. (default: false)",
+               "--page_test", true);
+    parser.add("thread_scaling",
+               "Instead of the usual variants, test the construction of the multi-threaded "
+               "algorithms (BBhash, PTHash, PPTHash) with 1, 2, 4, ... threads up to --threads, "
+               "reporting its speedup and parallel efficiency. --variant selects the "
+               "single-threaded variant to scale. (default: false)",
+               "--thread_scaling", true);
+    parser.add("tune",
+               "Pick the configuration (among the variants of --sweep, or their defaults) that "
+               "minimizes --tune_objective while meeting --max_bits_per_key and "
+               "--max_construction_seconds for --tune_n keys, extrapolating from trials on "
+               "samples of the keys. (default: false)",
+               "--tune", true);
+    parser.add("max_bits_per_key", "Space budget of the tuner. (default: unlimited)",
+               "--max_bits_per_key", false);
+    parser.add("max_construction_seconds",
+               "Construction time budget of the tuner. (default: unlimited)",
+               "--max_construction_seconds", false);
+    parser.add("tune_n",
+               "Number of keys the budget of the tuner refers to. (default: the number of keys)",
+               "--tune_n", false);
+    parser.add("tune_sample",
+               "Number of keys of the largest trial of the tuner; the other one uses a quarter of "
+               "them. (default: 1000000)",
+               "--tune_sample", false);
+    parser.add("tune_objective",
+               "Metric minimized by the tuner, one of: `lookup` (default), `construction`, "
+               "`space`.",
+               "--tune_objective", false);
+    parser.add("tune_build",
+               "Test the configuration picked by the tuner on all the keys. (default: false)",
+               "--tune_build", true);
+    parser.add("baseline",
+               "Compare the results with the ones of a baseline run written by --format json, "
+               "exiting with an error if a variant regressed. (default: none)",
+               "--baseline", false);
+    parser.add("thresholds",
+               "Comma-separated list of the metrics compared with the baseline and of their "
+               "maximum worsening in percent. (default: "
+               "bits_per_key=1,construction_seconds=10,lookup_ns_per_key=5)",
+               "--thresholds", false);
+    parser.add("repeat",
+               "Number of times the tests are repeated, so that the comparison with the baseline "
+               "can tell regressions from noise: both runs need at least 3 samples of each metric, "
+               "so the baseline must be recorded with --repeat 3 or more. (default: 3 with "
+               "--baseline, 1 otherwise)",
+               "--repeat", false);
     if (!parser.parse()) { return 1; }
 
     std::string algorithm_name = parser.get<std::string>("algorithm");
@@ -255,9 +2206,51 @@ int main(int argc, char** argv) {
     uint32_t num_lookup_runs =
         parser.parsed("num_lookup_runs") ? parser.get<uint64_t>("num_lookup_runs") : 1;
     uint64_t seed = parser.parsed("seed") ? parser.get<uint64_t>("seed") : 0;
+    uint64_t num_negative_keys =
+        parser.parsed("negative_keys") ? parser.get<uint64_t>("negative_keys") : 0;
+    std::string input = parser.parsed("input") ? parser.get<std::string>("input") : "";
     std::string generator = parser.parsed("generator")
                                 ? parser.get<std::string>("generator")
-                                : (parser.parsed("num_keys") ? "64" : "stdin");
+                                : (!input.empty() ? "file"
+                                                  : (parser.parsed("num_keys") ? "64" : "stdin"));
+    if (!input.empty() && generator != "file") {
+        std::cerr << "The keys cannot be both read from --input and generated by " << generator
+                  << std::endl;
+        return 1;
+    }
+    const bool pipeline = parser.parsed("pipeline") && parser.get<bool>("pipeline");
+    if (pipeline && generator != "stdin") {
+        std::cerr << "--pipeline requires the `stdin` generator" << std::endl;
+        return 1;
+    }
+    unsigned parse_threads = parser.parsed("parse_threads")
+                                 ? parser.get<unsigned>("parse_threads")
+                                 : std::max(1u, std::thread::hardware_concurrency());
+    KeyFileFormat input_format = KeyFileFormat::TEXT;
+    if (parser.parsed("input_format")) {
+        if (generator != "file") {
+            std::cerr << "--input_format requires --input" << std::endl;
+            return 1;
+        }
+        try {
+            input_format = parse_key_file_format(parser.get<std::string>("input_format"));
+        } catch (std::invalid_argument const& e) {
+            std::cerr << e.what() << "." << std::endl;
+            return 1;
+        }
+    }
+    std::string format_name = parser.parsed("format") ? parser.get<std::string>("format") : "text";
+
+    OutputFormat format;
+    try {
+        format = ResultWriter::parse_format(format_name);
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    ResultWriter writer(std::cout, format);
+    // keep the standard output clean when it carries machine-readable records
+    std::ostream& info = format == OutputFormat::TEXT ? std::cout : std::cerr;
 
     // recognize the algorithm
     const std::unordered_map<std::string, Algorithm> name_to_algorithm{
@@ -283,23 +2276,469 @@ int main(int argc, char** argv) {
 
     unsigned threads_num = parser.parsed("threads") ? parser.get<unsigned>("threads") : 0;
     if (threads_num == 0) threads_num = std::max(std::thread::hardware_concurrency(), 1u);
-    std::cout << threads_num << " threads available for multi-threaded calculations" << std::endl;
+    info << threads_num << " threads available for multi-threaded calculations" << std::endl;
+
+    TestConfiguration config;
+    config.num_construction_runs = num_construction_runs;
+    config.num_lookup_runs = num_lookup_runs;
+    config.seed = seed;
+    config.verbose = verbose;
+    config.generator = generator;
+    config.num_threads = threads_num;
+    config.num_latency_samples =
+        parser.parsed("latency_samples") ? parser.get<uint64_t>("latency_samples") : 0;
+    try {
+        config.workload.distribution = QueryWorkload::parse_distribution(
+            parser.parsed("queries") ? parser.get<std::string>("queries") : "sequential");
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    config.workload.num_queries =
+        parser.parsed("num_queries") ? parser.get<uint64_t>("num_queries") : 0;
+    config.workload.zipf_skew = parser.parsed("zipf_skew") ? parser.get<double>("zipf_skew") : 1.0;
+    if (parser.parsed("batch_sizes")) {
+        std::stringstream ss(parser.get<std::string>("batch_sizes"));
+        std::string batch_size;
+        while (std::getline(ss, batch_size, ',')) {
+            uint64_t size = 0;
+            try {
+                size = parse_integer_key<uint64_t>(batch_size);
+            } catch (std::invalid_argument const&) {}
+            if (size == 0) {
+                std::cerr << "Malformed batch size `" << batch_size
+                          << "`, expected an integer greater than zero" << std::endl;
+                return 1;
+            }
+            config.batch_sizes.push_back(size);
+        }
+    }
+    config.perf_counters = parser.parsed("perf") && parser.get<bool>("perf");
+    config.track_memory = parser.parsed("memory") && parser.get<bool>("memory");
+    if (config.track_memory && !heap_usage::enable()) {
+        std::cerr << "Warning: the heap usage cannot be tracked on this platform, it will be "
+                     "reported as 0"
+                  << std::endl;
+    }
+    config.num_seeds = parser.parsed("num_seeds") ? parser.get<uint32_t>("num_seeds") : 1;
+    if (config.num_seeds == 0) {
+        std::cerr << "The number of seeds must be greater than zero" << std::endl;
+        return 1;
+    }
+    try {
+        config.cache_mode = parse_cache_mode(
+            parser.parsed("cache_mode") ? parser.get<std::string>("cache_mode") : "warm");
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    if (parser.parsed("cache_scratch_mb")) {
+        config.cache_scratch_bytes = parser.get<uint64_t>("cache_scratch_mb") << 20;
+    } else {
+        uint64_t llc_bytes = last_level_cache_bytes();
+        config.cache_scratch_bytes = llc_bytes != 0 ? 4 * llc_bytes : uint64_t(64) << 20;
+    }
+    if (parser.parsed("cache_batch_size")) {
+        config.cache_batch_size = parser.get<uint64_t>("cache_batch_size");
+    }
+    if (parser.parsed("cache_lookups")) {
+        config.cache_lookups = parser.get<uint64_t>("cache_lookups");
+    }
+    if (config.cache_mode != CacheMode::WARM &&
+        (config.cache_scratch_bytes == 0 || config.cache_batch_size == 0 ||
+         config.cache_lookups == 0)) {
+        std::cerr << "The cache scratch size, batch size and number of lookups must be greater "
+                     "than zero"
+                  << std::endl;
+        return 1;
+    }
+    if (parser.parsed("save")) config.save_prefix = parser.get<std::string>("save");
+    if (parser.parsed("load")) {
+        config.load_prefix = parser.get<std::string>("load");
+        if (!config.save_prefix.empty() || config.num_seeds > 1) {
+            std::cerr << "The lookup-only mode (--load) cannot be combined with --save or "
+                         "--num_seeds, which require the construction"
+                      << std::endl;
+            return 1;
+        }
+    }
+    std::optional<ParameterGrid> sweep;
+    if (parser.parsed("sweep")) {
+        try {
+            sweep.emplace(parser.get<std::string>("sweep"));
+            validate_sweep(*sweep, algorithm);
+        } catch (std::invalid_argument const& e) {
+            std::cerr << e.what() << "." << std::endl;
+            return 1;
+        }
+    }
+    uint64_t scaling_min = parser.parsed("scaling") ? parser.get<uint64_t>("scaling") : 0;
+    uint32_t scaling_points =
+        parser.parsed("scaling_points") ? parser.get<uint32_t>("scaling_points") : 1;
+    if (scaling_min != 0 && scaling_points == 0) {
+        std::cerr << "The number of sizes per decade must be greater than zero" << std::endl;
+        return 1;
+    }
+    bool thread_scaling = parser.parsed("thread_scaling") && parser.get<bool>("thread_scaling");
+    if (thread_scaling && algorithm != BBhash && algorithm != PTHash && algorithm != PPTHash &&
+        algorithm != ALL) {
+        std::cerr << "The construction of " << algorithm_name << " is not multi-threaded"
+                  << std::endl;
+        return 1;
+    }
+    if (thread_scaling && sweep) {
+        std::cerr << "The thread scaling test (--thread_scaling) cannot be combined with --sweep, "
+                     "which can list the numbers of threads"
+                  << std::endl;
+        return 1;
+    }
+    bool tune = parser.parsed("tune") && parser.get<bool>("tune");
+    if (tune && (scaling_min != 0 || thread_scaling)) {
+        std::cerr << "The tuner (--tune) cannot be combined with --scaling or --thread_scaling"
+                  << std::endl;
+        return 1;
+    }
+    TuningBudget budget;
+    if (tune) {
+        if (!config.load_prefix.empty()) {
+            std::cerr << "The tuner (--tune) requires the construction, and cannot be combined "
+                         "with --load"
+                      << std::endl;
+            return 1;
+        }
+        if (parser.parsed("max_bits_per_key")) {
+            budget.max_bits_per_key = parser.get<double>("max_bits_per_key");
+        }
+        if (parser.parsed("max_construction_seconds")) {
+            budget.max_construction_seconds = parser.get<double>("max_construction_seconds");
+        }
+        if (parser.parsed("tune_n")) budget.target_num_keys = parser.get<uint64_t>("tune_n");
+        if (parser.parsed("tune_sample")) budget.sample_size = parser.get<uint64_t>("tune_sample");
+        if (budget.sample_size == 0) {
+            std::cerr << "The sample of the tuner cannot be empty" << std::endl;
+            return 1;
+        }
+        try {
+            budget.objective = parse_tuning_objective(
+                parser.parsed("tune_objective") ? parser.get<std::string>("tune_objective")
+                                                : "lookup");
+        } catch (std::invalid_argument const& e) {
+            std::cerr << e.what() << "." << std::endl;
+            return 1;
+        }
+        budget.full_build = parser.parsed("tune_build") && parser.get<bool>("tune_build");
+    }
+    try {
+        config.numa_mode =
+            parse_numa_mode(parser.parsed("numa") ? parser.get<std::string>("numa") : "none");
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    if (parser.parsed("numa_node")) config.numa_node = parser.get<int>("numa_node");
+    if (parser.parsed("numa_threads")) config.numa_threads = parser.get<unsigned>("numa_threads");
+    try {
+        mphf::set_default_page_mode(mphf::parse_page_mode(
+            parser.parsed("huge_pages") ? parser.get<std::string>("huge_pages") : "4k"));
+    } catch (std::invalid_argument const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
+    config.page_test = parser.parsed("page_test") && parser.get<bool>("page_test");
+    if (config.numa_mode != NumaMode::NONE) {
+        const std::vector<int> nodes = numa_nodes_with_cpus(numa_node_cpus());
+        if (!parser.parsed("numa_node")) config.numa_node = nodes.front();
+        if (std::find(nodes.begin(), nodes.end(), config.numa_node) == nodes.end() ||
+            config.numa_threads == 0) {
+            std::cerr << "The NUMA node must be one of the nodes with CPUs (";
+            for (size_t i = 0; i != nodes.size(); ++i) std::cerr << (i ? ", " : "") << nodes[i];
+            std::cerr << "), and the readers per node must be more than zero" << std::endl;
+            return 1;
+        }
+        info << nodes.size() << " NUMA nodes with CPUs" << std::endl;
+    }
+    config.max_lookup_threads =
+        parser.parsed("lookup_threads") ? parser.get<unsigned>("lookup_threads") : 0;
+    if (config.workload.distribution == QueryDistribution::TRACE) {
+        if (!parser.parsed("query_trace")) {
+            std::cerr << "The `trace` query distribution requires --query_trace" << std::endl;
+            return 1;
+        }
+        config.workload.trace_filename = parser.get<std::string>("query_trace");
+    }
+
+    std::optional<BaselineComparison> baseline;
+    if (parser.parsed("baseline")) {
+        std::string filename = parser.get<std::string>("baseline");
+        try {
+            std::ifstream is(filename);
+            if (!is) throw std::runtime_error("Unable to open `" + filename + "`");
+            baseline.emplace(read_json_records(is),
+                             parser.parsed("thresholds")
+                                 ? RegressionThresholds(parser.get<std::string>("thresholds"))
+                                 : RegressionThresholds());
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << "." << std::endl;
+            return 1;
+        }
+    }
+    uint32_t repeat = parser.parsed("repeat") ? parser.get<uint32_t>("repeat") : baseline ? 3 : 1;
+    if (repeat == 0) {
+        std::cerr << "The number of repetitions must be strictly greater than zero" << std::endl;
+        return 1;
+    }
+    if (baseline && repeat < BaselineComparison::min_samples) {
+        std::cerr << "The comparison with the baseline requires --repeat "
+                  << BaselineComparison::min_samples << " or more" << std::endl;
+        return 1;
+    }
+
+    int exit_code = 0;
+    auto run_tests = [&](auto const& testenv) {
+        if (tune) {
+            bool found = tune_algorithms(testenv, algorithm, sweep ? *sweep : ParameterGrid(),
+                                         budget, writer);
+            if (!found) exit_code = 1;
+        } else if (sweep) {
+            sweep_algorithms(testenv, algorithm, *sweep, writer);
+        } else if (thread_scaling) {
+            test_thread_scaling(testenv, algorithm, variant, threads_num, writer);
+        } else {
+            test_algorithms(testenv, algorithm, variant, threads_num);
+        }
+    };
+    auto run = [&](auto const& testenv) {
+        for (uint32_t i = 0; i != repeat; ++i) {
+            if (repeat > 1) std::cerr << "Repetition " << i + 1 << " of " << repeat << std::endl;
+            if (scaling_min != 0) {
+                test_scaling(testenv, scaling_min, scaling_points, writer, run_tests);
+            } else {
+                run_tests(testenv);
+            }
+        }
+        if (baseline && !compare_to_baseline(*baseline, testenv.results, writer)) exit_code = 1;
+    };
+
+    // tests the keys read from the input, holding out the negative keys from their end, with the
+    // hashes of the keys for FCH if they were computed while reading them
+    auto run_on_read_keys = [&](auto keys, std::vector<uint64_t> key_hashes = {},
+                                double key_hashing_seconds = 0) {
+        using T = typename decltype(keys)::value_type;
+        if (num_negative_keys >= keys.size()) {
+            std::cerr << "The number of negative keys must be smaller than the number of read keys"
+                      << std::endl;
+            return false;
+        }
+        auto negative_keys = split_tail_keys(keys, num_negative_keys);
+        if (!key_hashes.empty()) {
+            // only the hashing of the tested keys counts in their constructions
+            key_hashing_seconds *= 1.0 * keys.size() / (keys.size() + negative_keys.size());
+            key_hashes.resize(keys.size());
+        }
+        if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+            double average_size =
+                std::accumulate(keys.begin(), keys.end(), 0.0,
+                                [](double sum, T const& key) { return sum + key.size(); }) /
+                keys.size();
+            info << "Read " << keys.size() << " keys, with average length "
+                 << std::round(average_size * 100) / 100 << std::endl;
+        } else {
+            info << "Read " << keys.size() << " keys of " << 8 * sizeof(T) << " bits" << std::endl;
+        }
+        if (num_negative_keys != 0) {
+            info << "Held out " << negative_keys.size() << " keys for the negative lookup test"
+                 << std::endl;
+        }
+        TestEnvironment<T> testenv(std::move(keys), config, writer, std::move(negative_keys),
+                                   std::move(key_hashes), key_hashing_seconds);
+        run(testenv);
+        return true;
+    };
+
+    // hashes the keys of each block for FCH on the threads of a `PipelinedKeyReader`, so that the
+    // hashing overlaps with the reading of the next blocks and FCH only has to bucket them
+    using FCHHasher = mphf::hasher::Hasher<mphf::base_hasher::Murmur2BaseHasher>;
+    using FCHBuilder = mphf::FCH<FCHHasher>::Builder;
+    // (only when FCH alone is tested, since the hashes take 8 bytes per key)
+    const bool hash_while_reading = algorithm == FCH;
+    std::mutex block_hashes_mutex;
+    std::vector<std::vector<uint64_t>> block_hashes;
+    auto hash_block = [&](uint64_t index, std::vector<std::string_view> const& block_keys) {
+        if (!hash_while_reading) return;
+        std::vector<uint64_t> hashes(block_keys.size());
+        FCHBuilder::hash_keys(KeySpan<std::string_view>(block_keys), seed, hashes.data());
+        std::lock_guard<std::mutex> lock(block_hashes_mutex);
+        if (block_hashes.size() <= index) block_hashes.resize(index + 1);
+        block_hashes[index] = std::move(hashes);
+    };
+    // the hashes of the blocks in their order, as the `num_keys` keys returned by the reader
+    auto read_key_hashes = [&](uint64_t num_keys) {
+        std::vector<uint64_t> hashes;
+        if (!hash_while_reading) return hashes;
+        hashes.reserve(num_keys);
+        for (auto const& block : block_hashes) {
+            uint64_t n = std::min<uint64_t>(block.size(), num_keys - hashes.size());
+            hashes.insert(hashes.end(), block.begin(), block.begin() + n);
+        }
+        block_hashes = {};
+        return hashes;
+    };
+    auto print_hashing = [&](PipelinedKeyReader::Stats const& stats) {
+        if (!hash_while_reading) return;
+        info << "Hashed the keys for FCH while reading them in "
+             << std::round(stats.block_seconds * 1000) / 1000 << "s of thread time" << std::endl;
+    };
 
     if (generator == "stdin") {
         if (num_keys == 0)
-            std::cout << "Reading keys from stdin" << std::endl;
+            info << "Reading keys from stdin" << std::endl;
         else
-            std::cout << "Reading up to" << num_keys << " keys from stdin" << std::endl;
-        std::vector<std::string> keys = read_keys_from_stream(std::cin, '\n', num_keys);
-        double average_size =
-            std::accumulate(keys.begin(), keys.end(), 0.0,
-                            [](double sum, const std::string& key) { return sum + key.size(); }) /
-            keys.size();
-        std::cout << "Read " << keys.size() << " keys, with average length "
-                  << std::round(average_size * 100) / 100 << std::endl;
-        TestEnvironment<std::string> testenv(std::move(keys), num_construction_runs,
-                                             num_lookup_runs, seed, verbose);
-        test_algorithms(testenv, algorithm, variant, threads_num);
+            info << "Reading up to " << num_keys << " keys from stdin" << std::endl;
+        const uint64_t limit = num_keys == 0 ? 0 : num_keys + num_negative_keys;
+        if (pipeline) {
+            PipelinedKeyReader reader(parse_threads);
+            std::vector<std::string_view> keys = reader.read(std::cin, '\n', limit, hash_block);
+            auto const& stats = reader.stats();
+            info << "Read " << stats.bytes << " bytes in " << stats.blocks << " blocks and split "
+                 << "them into " << keys.size() << " keys with " << reader.num_threads()
+                 << " threads in " << std::round(stats.seconds * 1000) / 1000 << "s ("
+                 << std::round(stats.bytes / stats.seconds / 1e9 * 100) / 100 << " GB/s, "
+                 << std::round(keys.size() / stats.seconds / 1e6 * 100) / 100
+                 << " Mkeys/s): reading took " << std::round(stats.read_seconds * 1000) / 1000
+                 << "s and splitting " << std::round(stats.split_seconds * 1000) / 1000
+                 << "s of thread time" << std::endl;
+            print_hashing(stats);
+            std::vector<uint64_t> key_hashes = read_key_hashes(keys.size());
+            if (!run_on_read_keys(std::move(keys), std::move(key_hashes), stats.block_seconds)) {
+                return 1;
+            }
+        } else {
+            std::vector<std::string> keys = read_keys_from_stream(std::cin, '\n', limit);
+            if (!run_on_read_keys(std::move(keys))) return 1;
+        }
+    } else if (generator == "file") {
+        if (input.empty()) {
+            std::cerr << "The `file` generator requires --input" << std::endl;
+            return 1;
+        }
+        const uint64_t limit = num_keys == 0 ? 0 : num_keys + num_negative_keys;
+        Compression compression = Compression::NONE;
+        try {
+            compression = detect_file_compression(input);
+        } catch (std::runtime_error const& e) {
+            std::cerr << e.what() << "." << std::endl;
+            return 1;
+        }
+        if (compression != Compression::NONE) {
+            if (input_format != KeyFileFormat::TEXT) {
+                std::cerr << "The keys of the `" << key_file_format_name(input_format)
+                          << "` format are mapped, so they must be decompressed beforehand"
+                          << std::endl;
+                return 1;
+            }
+            info << "Decompressing the keys of " << input << " (" << compression_name(compression)
+                 << ")" << std::endl;
+            std::unique_ptr<DecompressingStreambuf> buffer;
+            PipelinedKeyReader reader(parse_threads);
+            std::vector<std::string_view> keys;
+            DecompressingStreambuf::Stats decompression;
+            try {
+                buffer = std::make_unique<DecompressingStreambuf>(input);
+                std::istream is(buffer.get());
+                keys = reader.read(is, '\n', limit, hash_block);
+                decompression = buffer->finish();
+            } catch (std::exception const& e) {
+                // e.g., std::bad_alloc, which the decompression thread also catches
+                std::cerr << e.what() << "." << std::endl;
+                return 1;
+            }
+            auto const& stats = reader.stats();
+            info << "Decompressed " << decompression.compressed_bytes << " bytes into "
+                 << decompression.bytes << " bytes with 1 thread in "
+                 << std::round(decompression.seconds * 1000) / 1000 << "s ("
+                 << std::round(decompression.bytes / decompression.seconds / 1e9 * 100) / 100
+                 << " GB/s)" << std::endl;
+            info << "Split " << stats.bytes << " bytes into " << keys.size() << " keys with "
+                 << reader.num_threads() << " threads in "
+                 << std::round(stats.split_seconds * 1000) / 1000 << "s of thread time ("
+                 << std::round(stats.bytes / stats.split_seconds / 1e9 * 100) / 100
+                 << " GB/s per thread), " << std::round(stats.seconds * 1000) / 1000
+                 << "s in total (" << std::round(keys.size() / stats.seconds / 1e6 * 100) / 100
+                 << " Mkeys/s)" << std::endl;
+            print_hashing(stats);
+            std::vector<uint64_t> key_hashes = read_key_hashes(keys.size());
+            if (!run_on_read_keys(std::move(keys), std::move(key_hashes), stats.block_seconds)) {
+                return 1;
+            }
+            return exit_code;
+        }
+        if (input_format != KeyFileFormat::TEXT) {
+            info << "Mapping the keys of " << input << " (" << key_file_format_name(input_format)
+                 << " format)" << std::endl;
+            std::unique_ptr<KeyFile> file;
+            try {
+                file = std::make_unique<KeyFile>(input, input_format);
+            } catch (std::runtime_error const& e) {
+                std::cerr << e.what() << "." << std::endl;
+                return 1;
+            }
+            // times the loading of the keys, which involves no parsing, then tests them
+            auto load_and_run = [&](auto load) {
+                decltype(load()) keys;
+                Chrono chrono;
+                chrono.start();
+                try {
+                    keys = load();
+                } catch (std::runtime_error const& e) {
+                    std::cerr << e.what() << "." << std::endl;
+                    return false;
+                }
+                chrono.stop();
+                double seconds = chrono.elapsed_time();
+                info << "Loaded " << keys.size() << " keys of " << file->num_keys() << " in "
+                     << std::round(seconds * 1000) / 1000 << "s ("
+                     << std::round(keys.size() / seconds / 1e6 * 100) / 100 << " Mkeys/s)"
+                     << std::endl;
+                return run_on_read_keys(std::move(keys));
+            };
+            bool success = false;
+            switch (input_format) {
+                case KeyFileFormat::U32:
+                    success = load_and_run([&] { return file->integers<uint32_t>(limit); });
+                    break;
+                case KeyFileFormat::U64:
+                    success = load_and_run([&] { return file->integers<uint64_t>(limit); });
+                    break;
+                case KeyFileFormat::U128:
+                    success = load_and_run([&] { return file->integers<__uint128_t>(limit); });
+                    break;
+                default:
+                    success = load_and_run([&] { return file->strings(limit); });
+            }
+            return success ? exit_code : 1;
+        }
+        info << "Mapping the keys of " << input << std::endl;
+        std::unique_ptr<KeyArena> arena;
+        std::vector<std::string_view> keys;
+        Chrono chrono;
+        chrono.start();
+        try {
+            arena = std::make_unique<KeyArena>(input);
+            keys = arena->split('\n', limit, parse_threads);
+        } catch (std::runtime_error const& e) {
+            std::cerr << e.what() << "." << std::endl;
+            return 1;
+        }
+        chrono.stop();
+        double seconds = chrono.elapsed_time();
+        info << "Split " << arena->size() << " bytes into " << keys.size() << " keys with "
+             << parse_threads << " threads in " << std::round(seconds * 1000) / 1000 << "s ("
+             << std::round(arena->size() / seconds / 1e9 * 100) / 100 << " GB/s, "
+             << std::round(keys.size() / seconds / 1e6 * 100) / 100 << " Mkeys/s), "
+             << std::round(100.0 * (arena->size() + keys.size() * sizeof(std::string_view)) /
+                           keys.size()) / 100
+             << " bytes/key" << std::endl;
+        if (!run_on_read_keys(std::move(keys))) return 1;
     } else {
         if (generator != "64" && generator != "xs32" && generator != "xs64") {
             std::cerr << "Wrong generator name." << std::endl;
@@ -309,22 +2748,46 @@ int main(int argc, char** argv) {
             std::cerr << "The number of keys cannot be zero" << std::endl;
             return 1;
         }
-        std::cout << "Generating " << num_keys << " random keys by " << generator
-                  << " generator (the name of the generator contains the size of each key in bits)."
-                  << std::endl;
-        if (generator == "64" || generator == "xs64") {
-            std::vector<uint64_t> keys = generator == "64"
-                                             ? create_random_distinct_keys<uint64_t>(num_keys, seed)
-                                             : create_xorshift64_keys(num_keys, seed);
-            TestEnvironment<uint64_t> testenv(std::move(keys), num_construction_runs,
-                                              num_lookup_runs, seed, verbose);
-            test_algorithms(testenv, algorithm, variant, threads_num);
+        info << "Generating " << num_keys << " random keys by " << generator
+             << " generator (the name of the generator contains the size of each key in bits)."
+             << std::endl;
+        // xor-shift generators never repeat a value within their period, so the keys following
+        // the first `num_keys` ones are distinct from them
+        if (generator == "64") {
+            std::vector<uint64_t> keys = create_random_distinct_keys<uint64_t>(num_keys, seed);
+            std::vector<uint64_t> negative_keys =
+                create_random_non_member_keys(keys, num_negative_keys, seed);
+            TestEnvironment<uint64_t> testenv(std::move(keys), config, writer,
+                                              std::move(negative_keys));
+            run(testenv);
+        } else if (generator == "xs64") {
+            std::vector<uint64_t> keys = create_xorshift64_keys(num_keys + num_negative_keys, seed);
+            std::vector<uint64_t> negative_keys = split_tail_keys(keys, num_negative_keys);
+            TestEnvironment<uint64_t> testenv(std::move(keys), config, writer,
+                                              std::move(negative_keys));
+            run(testenv);
         } else {
-            std::vector<uint32_t> keys = create_xorshift32_keys(num_keys, seed);
-            TestEnvironment<uint32_t> testenv(std::move(keys), num_construction_runs,
-                                              num_lookup_runs, seed, verbose);
-            test_algorithms(testenv, algorithm, variant, threads_num);
+            if (num_keys + num_negative_keys >= (uint64_t(1) << 32)) {
+                std::cerr << "The xs32 generator cannot create more than 2^32-1 distinct keys"
+                          << std::endl;
+                return 1;
+            }
+            std::vector<uint32_t> keys = create_xorshift32_keys(num_keys + num_negative_keys, seed);
+            std::vector<uint32_t> negative_keys = split_tail_keys(keys, num_negative_keys);
+            TestEnvironment<uint32_t> testenv(std::move(keys), config, writer,
+                                              std::move(negative_keys));
+            run(testenv);
         }
     }
-    return 0;
+    return exit_code;
+}
+
+int main(int argc, char** argv) {
+    // errors of the inputs found only when the tests start, e.g., a malformed query trace
+    try {
+        return run_benchmark(argc, argv);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "." << std::endl;
+        return 1;
+    }
 }